@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32C, bitwise (no table)
+uint32_t crc32c_bitwise(const uint8_t *data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+    }
+  }
+
+  return ~crc;
+}
+
+// CRC-32C, byte-wise table lookup
+uint32_t crc32c_table(const uint32_t *table, const uint8_t *data,
+                      size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+
+  for (size_t i = 0; i < length; i++) {
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Hamming SEC syndrome of 64-bit word, parity masks per check bit
+uint32_t hamming_syndrome(const uint64_t *masks, uint64_t word,
+                          uint32_t checks) {
+  uint32_t syndrome = 0;
+
+  for (uint32_t i = 0; i < checks; i++) {
+    uint64_t bits = word & masks[i];
+
+    bits ^= bits >> 32;
+    bits ^= bits >> 16;
+    bits ^= bits >> 8;
+    bits ^= bits >> 4;
+    bits ^= bits >> 2;
+    bits ^= bits >> 1;
+
+    syndrome |= (uint32_t)(bits & 1) << i;
+  }
+
+  return syndrome;
+}
+
+// BCH syndromes S_j = sum(data_i * alpha^(i * j)) over GF(2^m) with log tables
+void bch_syndrome(const uint16_t *exp, const uint16_t *log, uint32_t order,
+                  const uint8_t *data, size_t bits, uint16_t *syndrome,
+                  uint32_t count) {
+  for (uint32_t j = 0; j < count; j++) {
+    syndrome[j] = 0;
+  }
+
+  for (size_t i = 0; i < bits; i++) {
+    if (data[i >> 3] & (1 << (i & 7))) {
+      for (uint32_t j = 0; j < count; j++) {
+        syndrome[j] ^= exp[(i * (j + 1)) % order];
+      }
+    }
+  }
+
+  for (uint32_t j = 0; j < count; j++) {
+    syndrome[j] = syndrome[j] ? log[syndrome[j]] : 0xFFFF;
+  }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <stdint.h>
+
+#define INVALID 0xFFFFFFFFu
+
+struct Entry {
+  uint32_t lpn;
+  uint32_t ppn;
+};
+
+// Page-level mapping table lookup with open addressing (linear probing)
+uint32_t mapping_lookup(const struct Entry *table, uint32_t mask,
+                        uint32_t lpn) {
+  uint32_t slot = (lpn * 0x9E3779B1u) & mask;
+
+  while (table[slot].lpn != INVALID) {
+    if (table[slot].lpn == lpn) {
+      return table[slot].ppn;
+    }
+
+    slot = (slot + 1) & mask;
+  }
+
+  return INVALID;
+}
+
+// Two-level (directory + leaf) mapping lookup with cached mapping table
+uint32_t mapping_lookup_cmt(uint32_t *const *directory, uint32_t leafBits,
+                            uint32_t lpn, uint32_t *hit) {
+  const uint32_t *leaf = directory[lpn >> leafBits];
+
+  if (leaf == 0) {
+    *hit = 0;
+
+    return INVALID;
+  }
+
+  *hit = 1;
+
+  return leaf[lpn & ((1u << leafBits) - 1)];
+}
+
+// Range update of mapping table after sequential write
+void mapping_update(uint32_t *l2p, uint32_t *valid, uint32_t lpn,
+                    uint32_t ppn, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t old = l2p[lpn + i];
+
+    if (old != INVALID) {
+      valid[old >> 5] &= ~(1u << (old & 31));
+    }
+
+    l2p[lpn + i] = ppn + i;
+    valid[(ppn + i) >> 5] |= 1u << ((ppn + i) & 31);
+  }
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Loops are written by hand - keep compiler from calling memcpy
+#define NOBUILTIN __attribute__((no_builtin("memcpy", "memset")))
+
+NOBUILTIN void copy_bytes(uint8_t *dst, const uint8_t *src, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    dst[i] = src[i];
+  }
+}
+
+NOBUILTIN void copy_words(uint64_t *dst, const uint64_t *src, size_t words) {
+  for (size_t i = 0; i < words; i += 4) {
+    uint64_t a = src[i];
+    uint64_t b = src[i + 1];
+    uint64_t c = src[i + 2];
+    uint64_t d = src[i + 3];
+
+    dst[i] = a;
+    dst[i + 1] = b;
+    dst[i + 2] = c;
+    dst[i + 3] = d;
+  }
+}
+
+NOBUILTIN void fill_words(uint32_t *dst, uint32_t value, size_t words) {
+  for (size_t i = 0; i < words; i++) {
+    dst[i] = value;
+  }
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <stdint.h>
+
+struct Request {
+  uint64_t lba;
+  uint32_t length;
+  uint32_t tag;
+};
+
+struct Queue {
+  struct Request *entries;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t mask;
+};
+
+// Ring buffer submission queue
+int queue_push(struct Queue *queue, const struct Request *request) {
+  if (queue->tail - queue->head > queue->mask) {
+    return 0;
+  }
+
+  queue->entries[queue->tail & queue->mask] = *request;
+  queue->tail++;
+
+  return 1;
+}
+
+int queue_pop(struct Queue *queue, struct Request *request) {
+  if (queue->head == queue->tail) {
+    return 0;
+  }
+
+  *request = queue->entries[queue->head & queue->mask];
+  queue->head++;
+
+  return 1;
+}
+
+// Pick request with smallest LBA distance from current position (SSTF)
+uint32_t queue_schedule(const struct Queue *queue, uint64_t position) {
+  uint64_t best = UINT64_MAX;
+  uint32_t index = queue->head;
+
+  for (uint32_t i = queue->head; i != queue->tail; i++) {
+    uint64_t lba = queue->entries[i & queue->mask].lba;
+    uint64_t distance = lba > position ? lba - position : position - lba;
+
+    if (distance < best) {
+      best = distance;
+      index = i;
+    }
+  }
+
+  return index;
+}
@@ -0,0 +1,119 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Copyright (C) 2019 CAMELab
+#
+# Author: Donghyun Gouk <kukdh1@camelab.org>
+#
+# Measure runtime overhead of instrumented kernels on host
+#
+# Usage: overhead.sh <llvm-simplessd.so> <inststat-generator>
+#                    <libinststat-runtime.a> [output directory]
+#
+# overhead/kernels.cc is compiled for host, and its statistics are generated
+# from cortex-a57 assembly (same as simulated firmware). Kernels are built
+# without pass (plain) and with each mode below, and run by overhead/main.cc.
+# For each mode and kernel, time per call is compared with plain build.
+# Counter updates per call come from another build of same mode with
+# -inststat-count-updates (edge mode counts chord increments as updates), and
+# code size is size of kernel symbol.
+
+PASS=$1
+GENERATOR=$2
+RUNTIME=$3
+OUTPUT=${4:-bench_build}/overhead
+
+CXX=${CXX:-clang++}
+OPT=${OPT:-opt}
+LLC=${LLC:-llc}
+NM=${NM:-nm}
+CALLS=${CALLS:-1000}
+
+# name:flags (comma separated)
+MODES=${MODES:-"inststat: edge:-inststat-edge-profile expected:-inststat-expected
+  cycles:-inststat-level=cycles shard:-inststat-shard
+  sample:-inststat-sample=16 memory:-inststat-memory"}
+
+SOURCE_DIR=$(dirname $0)
+ROOT_DIR=$(cd $SOURCE_DIR/.. && pwd)
+PREFIX=$OUTPUT/kernels
+
+if [ -z "$RUNTIME" ]; then
+  echo "Usage: $0 <llvm-simplessd.so> <inststat-generator>" \
+    "<libinststat-runtime.a> [output directory]"
+  exit 1
+fi
+
+mkdir -p $OUTPUT
+
+# Statistics from cortex-a57 assembly of host IR
+$CXX -O2 -g -std=c++17 -S -emit-llvm -o $PREFIX.ll \
+  $SOURCE_DIR/overhead/kernels.cc || exit 2
+$OPT -enable-new-pm=0 -load $PASS --blockcollector -o $PREFIX.collect.bc \
+  $PREFIX.ll || exit 2
+$LLC -O2 -mtriple=aarch64-none-elf -mcpu=cortex-a57 -filetype=asm \
+  -o $PREFIX.ll.S $PREFIX.collect.bc 2> $PREFIX.llc.log || exit 2
+$GENERATOR $PREFIX.ll > $PREFIX.generator.log || exit 3
+
+$CXX -O2 -std=c++17 -I$ROOT_DIR -c -o $OUTPUT/main.o \
+  $SOURCE_DIR/overhead/main.cc || exit 2
+
+# build <name> [applier flags...]
+build() {
+  local name=$1
+
+  shift
+
+  if [ "$name" = "plain" ]; then
+    $CXX -O2 -c -o $OUTPUT/$name.o $PREFIX.ll || exit 4
+  else
+    $OPT -enable-new-pm=0 -load $PASS --inststat "$@" -o $OUTPUT/$name.bc \
+      $PREFIX.ll || exit 4
+    $CXX -O2 -c -o $OUTPUT/$name.o $OUTPUT/$name.bc || exit 4
+  fi
+
+  $CXX -O2 -o $OUTPUT/$name $OUTPUT/main.o $OUTPUT/$name.o $RUNTIME \
+    -lpthread || exit 4
+  $OUTPUT/$name $CALLS > $OUTPUT/$name.txt || exit 5
+
+  # <symbol> <bytes>
+  $NM -S -t d --defined-only $OUTPUT/$name.o |
+    awk '$4 ~ /^kernel_/ { print substr($4, 8), $2 + 0 }' \
+    > $OUTPUT/$name.size
+}
+
+build plain
+
+printf "%-10s %-15s %10s %10s %9s %12s %7s %7s %8s\n" "mode" "kernel" \
+  "plain(ns)" "mode(ns)" "overhead" "updates/call" "plain" "size" "growth"
+
+for mode in $MODES; do
+  NAME=${mode%%:*}
+  FLAGS=$(echo ${mode#*:} | tr ',' ' ')
+
+  build $NAME $FLAGS
+  build $NAME.count $FLAGS -inststat-count-updates
+
+  # Join by kernel name: main output is "<kernel> <ns> <cycles> <updates>"
+  awk -v mode=$NAME '
+    FILENAME ~ /plain.txt$/ { plain[$1] = $2; next }
+    FILENAME ~ /plain.size$/ { plainSize[$1] = $2; next }
+    FILENAME ~ /count.txt$/ { updates[$1] = $4; next }
+    FILENAME ~ /size$/ { size[$1] = $2; next }
+    {
+      order[count++] = $1
+      time[$1] = $2
+    }
+    END {
+      for (i = 0; i < count; i++) {
+        k = order[i]
+
+        printf "%-10s %-15s %10.1f %10.1f %8.1f%% %12.1f %7d %7d %7.1f%%\n",
+          mode, k, plain[k], time[k],
+          (plain[k] > 0 ? (time[k] - plain[k]) * 100 / plain[k] : 0),
+          updates[k], plainSize[k], size[k],
+          (plainSize[k] > 0 ? (size[k] - plainSize[k]) * 100 / plainSize[k] : 0)
+      }
+    }' $OUTPUT/plain.txt $OUTPUT/plain.size $OUTPUT/$NAME.count.txt \
+    $OUTPUT/$NAME.size $OUTPUT/$NAME.txt
+done
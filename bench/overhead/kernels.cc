@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <cstring>
+
+#include "workload.hh"
+
+using SimpleSSD::CPU::Function;
+using SimpleSSD::CPU::markFunction;
+
+extern "C" {
+
+// Translate LPN of each read request
+void kernel_mapping_read(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint64_t sum = 0;
+
+  for (uint32_t i = 0; i < w.requests; i++) {
+    uint32_t ppn = w.l2p[w.lpns[i] & (w.pages - 1)];
+
+    if (ppn != INVALID) {
+      sum += ppn;
+    }
+  }
+
+  w.result += sum;
+}
+
+// Out-of-place update: invalidate old page, program next free page
+void kernel_mapping_write(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint32_t physical = w.blocks * w.pagesPerBlock;
+
+  for (uint32_t i = 0; i < w.requests; i++) {
+    uint32_t lpn = w.lpns[i] & (w.pages - 1);
+    uint32_t old = w.l2p[lpn];
+
+    if (old != INVALID) {
+      w.validCount[old / w.pagesPerBlock]--;
+      w.p2l[old] = INVALID;
+    }
+
+    uint32_t ppn = w.writePointer;
+
+    w.writePointer = ppn + 1 < physical ? ppn + 1 : 0;
+    w.l2p[lpn] = ppn;
+    w.p2l[ppn] = lpn;
+    w.validCount[ppn / w.pagesPerBlock]++;
+  }
+}
+
+// Greedy victim selection: used block with least valid pages
+void kernel_gc_select(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint32_t victim = INVALID;
+  uint32_t least = INVALID;
+
+  for (uint32_t b = 0; b < w.blocks; b++) {
+    if (w.freeBitmap[b / 64] & (1ull << (b % 64))) {
+      continue;
+    }
+
+    if (w.validCount[b] < least) {
+      least = w.validCount[b];
+      victim = b;
+    }
+  }
+
+  w.result += victim;
+}
+
+// Allocate free blocks from bitmap, then release them
+void kernel_block_alloc(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint32_t words = (w.blocks + 63) / 64;
+  uint32_t allocated[16];
+  uint32_t count = 0;
+
+  for (uint32_t word = 0; word < words && count < 16; word++) {
+    while (w.freeBitmap[word] != 0 && count < 16) {
+      uint32_t bit = __builtin_ctzll(w.freeBitmap[word]);
+
+      w.freeBitmap[word] &= ~(1ull << bit);
+      allocated[count++] = word * 64 + bit;
+    }
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    w.freeBitmap[allocated[i] / 64] |= 1ull << (allocated[i] % 64);
+  }
+
+  w.result += count;
+}
+
+// Fill submission queue, then dispatch in SSTF order
+void kernel_queue_schedule(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint32_t head = 0;
+  uint32_t tail = 0;
+  uint64_t position = 0;
+
+  for (uint32_t i = 0; i < w.requests && tail - head <= w.mask; i++) {
+    w.queue[tail & w.mask] = Request{w.lpns[i], 8, i};
+    tail++;
+  }
+
+  while (head != tail) {
+    uint64_t best = ~0ull;
+    uint32_t index = head;
+
+    for (uint32_t i = head; i != tail; i++) {
+      uint64_t lba = w.queue[i & w.mask].lba;
+      uint64_t distance = lba > position ? lba - position : position - lba;
+
+      if (distance < best) {
+        best = distance;
+        index = i;
+      }
+    }
+
+    // Move selected request to head
+    Request selected = w.queue[index & w.mask];
+
+    w.queue[index & w.mask] = w.queue[head & w.mask];
+    head++;
+
+    position = selected.lba + selected.length;
+  }
+
+  w.result += position;
+}
+
+// CRC-32C of page, bitwise (no table)
+void kernel_crc32c(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint32_t crc = 0xFFFFFFFF;
+
+  for (uint32_t i = 0; i < w.pageSize; i++) {
+    crc ^= w.buffer[i];
+
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+    }
+  }
+
+  w.result += ~crc;
+}
+
+// Hamming parity of page (position of each set bit XORed)
+void kernel_ecc_parity(Function &func, Workload &w) {
+  markFunction(func);
+
+  auto words = reinterpret_cast<const uint64_t *>(w.buffer);
+  uint32_t syndrome = 0;
+  uint32_t parity = 0;
+
+  for (uint32_t i = 0; i < w.pageSize / 8; i++) {
+    uint64_t word = words[i];
+
+    parity ^= __builtin_parityll(word);
+
+    while (word) {
+      syndrome ^= i * 64 + __builtin_ctzll(word);
+      word &= word - 1;
+    }
+  }
+
+  w.result += syndrome ^ parity;
+}
+
+// Copy page from buffer and clear spare area
+void kernel_page_copy(Function &func, Workload &w) {
+  markFunction(func);
+
+  memcpy(w.page, w.buffer, w.pageSize);
+  memset(w.buffer + w.pageSize - 64, 0, 64);
+
+  w.result += w.page[w.result % w.pageSize];
+}
+
+// Branch on every request - two or three instructions per block
+void kernel_tiny_blocks(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint64_t a = 0;
+  uint64_t b = 0;
+
+  for (uint32_t i = 0; i < w.requests; i++) {
+    uint32_t lpn = w.lpns[i];
+
+    if (lpn & 1) {
+      a++;
+    }
+    else {
+      b++;
+    }
+
+    if (lpn & 2) {
+      a ^= b;
+    }
+
+    if (lpn & 4) {
+      b += 3;
+    }
+  }
+
+  w.result += a + b;
+}
+
+// Long dependency-free arithmetic in one block per iteration
+void kernel_large_block(Function &func, Workload &w) {
+  markFunction(func);
+
+  uint64_t h[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+  for (uint32_t i = 0; i < w.requests; i++) {
+    uint64_t x = w.lpns[i];
+
+    h[0] = (h[0] ^ x) * 0x9E3779B97F4A7C15ull;
+    h[1] = (h[1] + x) * 0xC2B2AE3D27D4EB4Full;
+    h[2] = (h[2] ^ (x << 7)) * 0x165667B19E3779F9ull;
+    h[3] = (h[3] + (x >> 3)) * 0x27D4EB2F165667C5ull;
+    h[4] = (h[4] ^ (x << 13)) * 0x9E3779B97F4A7C15ull;
+    h[5] = (h[5] + (x >> 11)) * 0xC2B2AE3D27D4EB4Full;
+    h[6] = (h[6] ^ (x << 17)) * 0x165667B19E3779F9ull;
+    h[7] = (h[7] + (x >> 19)) * 0x27D4EB2F165667C5ull;
+  }
+
+  w.result += h[0] ^ h[1] ^ h[2] ^ h[3] ^ h[4] ^ h[5] ^ h[6] ^ h[7];
+}
+
+}  // extern "C"
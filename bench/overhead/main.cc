@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "src/runtime/control.hh"
+#include "workload.hh"
+
+namespace SimpleSSD::CPU {
+
+void markFunction(Function &) {}
+
+}  // namespace SimpleSSD::CPU
+
+namespace {
+
+const struct {
+  const char *name;
+  Kernel kernel;
+} kernels[] = {
+    {"mapping_read", kernel_mapping_read},
+    {"mapping_write", kernel_mapping_write},
+    {"gc_select", kernel_gc_select},
+    {"block_alloc", kernel_block_alloc},
+    {"queue_schedule", kernel_queue_schedule},
+    {"crc32c", kernel_crc32c},
+    {"ecc_parity", kernel_ecc_parity},
+    {"page_copy", kernel_page_copy},
+    {"tiny_blocks", kernel_tiny_blocks},
+    {"large_block", kernel_large_block},
+};
+
+const uint32_t trials = 5;
+
+void setup(Workload &w) {
+  uint64_t seed = 0x2545F4914F6CDD1Dull;
+
+  auto random = [&seed]() {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+
+    return seed;
+  };
+
+  // 256 MiB logical space of 4 KiB pages, 25% over-provisioning
+  w.pages = 1u << 16;
+  w.pagesPerBlock = 256;
+  w.blocks = w.pages / w.pagesPerBlock * 5 / 4;
+  w.writePointer = 0;
+
+  w.l2p = new uint32_t[w.pages];
+  w.p2l = new uint32_t[w.blocks * w.pagesPerBlock];
+  w.validCount = new uint32_t[w.blocks]();
+  w.freeBitmap = new uint64_t[(w.blocks + 63) / 64]();
+
+  std::fill(w.l2p, w.l2p + w.pages, INVALID);
+  std::fill(w.p2l, w.p2l + w.blocks * w.pagesPerBlock, INVALID);
+
+  for (uint32_t b = 0; b < w.blocks; b++) {
+    if (random() % 4 == 0) {
+      w.freeBitmap[b / 64] |= 1ull << (b % 64);
+    }
+  }
+
+  w.requests = 1024;
+  w.lpns = new uint32_t[w.requests];
+
+  for (uint32_t i = 0; i < w.requests; i++) {
+    w.lpns[i] = random() % w.pages;
+  }
+
+  w.mask = 31;
+  w.queue = new Request[w.mask + 1];
+
+  w.pageSize = 4096;
+  w.buffer = new uint8_t[w.pageSize];
+  w.page = new uint8_t[w.pageSize];
+
+  for (uint32_t i = 0; i < w.pageSize; i++) {
+    w.buffer[i] = random();
+  }
+
+  w.result = 0;
+}
+
+void release(Workload &w) {
+  delete[] w.l2p;
+  delete[] w.p2l;
+  delete[] w.validCount;
+  delete[] w.freeBitmap;
+  delete[] w.lpns;
+  delete[] w.queue;
+  delete[] w.buffer;
+  delete[] w.page;
+}
+
+}  // namespace
+
+/**
+ * Run each kernel and print one line per kernel:
+ *   <kernel> <ns per call> <cycles per call> <counter updates per call>
+ *
+ * Time is the best of five trials. Updates are counted only when kernels are
+ * compiled with -inststat-count-updates.
+ */
+int main(int argc, char *argv[]) {
+  uint32_t calls = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000;
+  Workload w;
+
+  setup(w);
+
+  for (auto &entry : kernels) {
+    SimpleSSD::CPU::Function func{};
+    double best = 1e300;
+
+    // Warm up
+    entry.kernel(func, w);
+
+    func = SimpleSSD::CPU::Function{};
+
+    auto updates = SimpleSSD::LLVM::Runtime::getCounterUpdates();
+
+    for (uint32_t t = 0; t < trials; t++) {
+      auto begin = std::chrono::steady_clock::now();
+
+      for (uint32_t i = 0; i < calls; i++) {
+        entry.kernel(func, w);
+      }
+
+      auto end = std::chrono::steady_clock::now();
+
+      best = std::min(best, std::chrono::duration<double, std::nano>(end - begin)
+                                    .count() /
+                                calls);
+    }
+
+    updates = SimpleSSD::LLVM::Runtime::getCounterUpdates() - updates;
+
+    printf("%s %.1f %.1f %.1f\n", entry.name, best,
+           (double)func.cycles / (trials * calls),
+           (double)updates / (trials * calls));
+  }
+
+  release(w);
+
+  // Keep results alive
+  return w.result == 0x5EED ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __BENCH_OVERHEAD_WORKLOAD_HH__
+#define __BENCH_OVERHEAD_WORKLOAD_HH__
+
+#include <cinttypes>
+
+namespace SimpleSSD::CPU {
+
+// Same layout as CPU::Function of SimpleSSD (with vector counter)
+struct Function {
+  uint64_t branch;
+  uint64_t load;
+  uint64_t store;
+  uint64_t arithmetic;
+  uint64_t floatingPoint;
+  uint64_t otherInsts;
+  uint64_t cycles;
+  uint64_t vector;
+};
+
+// Removed by applier, no-op in uninstrumented build
+void markFunction(Function &);
+
+}  // namespace SimpleSSD::CPU
+
+#define INVALID 0xFFFFFFFFu
+
+struct Request {
+  uint64_t lba;
+  uint32_t length;
+  uint32_t tag;
+};
+
+//! State of small page-mapping FTL, shared by all kernels
+struct Workload {
+  // Mapping table
+  uint32_t *l2p;         //!< LPN -> PPN
+  uint32_t *p2l;         //!< PPN -> LPN
+  uint32_t *validCount;  //!< Valid pages of each block
+  uint64_t *freeBitmap;  //!< Bit set = free block
+
+  uint32_t pages;  //!< Logical pages, power of two
+  uint32_t blocks;
+  uint32_t pagesPerBlock;
+  uint32_t writePointer;  //!< Next physical page
+
+  // Host requests
+  uint32_t *lpns;
+  uint32_t requests;
+
+  Request *queue;
+  uint32_t mask;
+
+  // Page buffers
+  uint8_t *buffer;
+  uint8_t *page;
+  uint32_t pageSize;
+
+  uint64_t result;
+};
+
+typedef void (*Kernel)(SimpleSSD::CPU::Function &, Workload &);
+
+extern "C" {
+
+// FTL-like kernels
+void kernel_mapping_read(SimpleSSD::CPU::Function &, Workload &);
+void kernel_mapping_write(SimpleSSD::CPU::Function &, Workload &);
+void kernel_gc_select(SimpleSSD::CPU::Function &, Workload &);
+void kernel_block_alloc(SimpleSSD::CPU::Function &, Workload &);
+void kernel_queue_schedule(SimpleSSD::CPU::Function &, Workload &);
+void kernel_crc32c(SimpleSSD::CPU::Function &, Workload &);
+void kernel_ecc_parity(SimpleSSD::CPU::Function &, Workload &);
+void kernel_page_copy(SimpleSSD::CPU::Function &, Workload &);
+
+// Synthetic: many tiny blocks (worst case), one large block (best case)
+void kernel_tiny_blocks(SimpleSSD::CPU::Function &, Workload &);
+void kernel_large_block(SimpleSSD::CPU::Function &, Workload &);
+
+}  // extern "C"
+
+#endif
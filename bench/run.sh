@@ -0,0 +1,100 @@
+#!/bin/bash
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Copyright (C) 2019 CAMELab
+#
+# Author: Donghyun Gouk <kukdh1@camelab.org>
+#
+# Compare per-block cycles of inststat-generator cost models with llvm-mca
+#
+# Usage: run.sh <inststat-generator> [output directory]
+#
+# Each machine basic block of kernels/*.c is compiled for every target below.
+# Cost of block from our model (sum of instruction cycles) is compared with
+# cycles per iteration reported by llvm-mca for the same instructions.
+
+GENERATOR=$1
+OUTPUT=${2:-bench_build}
+
+CLANG=${CLANG:-clang}
+LLC=${LLC:-llc}
+MCA=${MCA:-llvm-mca}
+ITERATIONS=100
+
+# triple:cpu
+TARGETS="aarch64-none-elf:cortex-a57 armv8r-none-eabi:cortex-r52"
+
+SOURCE_DIR=$(dirname $0)
+
+if [ -z "$GENERATOR" ]; then
+  echo "Usage: $0 <inststat-generator> [output directory]"
+  exit 1
+fi
+
+printf "%-12s %-10s %7s %12s %12s %9s %9s\n" "cpu" "kernel" "blocks" \
+  "model" "llvm-mca" "error" "mean|err|"
+
+for target in $TARGETS; do
+  TRIPLE=${target%%:*}
+  CPU=${target##*:}
+
+  mkdir -p $OUTPUT/$CPU
+
+  for kernel in $SOURCE_DIR/kernels/*.c; do
+    NAME=$(basename $kernel .c)
+    PREFIX=$OUTPUT/$CPU/$NAME
+
+    $CLANG --target=$TRIPLE -mcpu=$CPU -O2 -ffreestanding -S -emit-llvm \
+      -o $PREFIX.ll $kernel || exit 2
+    $LLC -O2 -mtriple=$TRIPLE -mcpu=$CPU -filetype=asm -o $PREFIX.S \
+      $PREFIX.ll || exit 2
+    $GENERATOR --blocks $PREFIX.S $CPU > $PREFIX.mca.S || exit 3
+    $MCA -mtriple=$TRIPLE -mcpu=$CPU -iterations=$ITERATIONS \
+      -o $PREFIX.mca.txt $PREFIX.mca.S 2> $PREFIX.mca.log || exit 4
+
+    # Join by region name: "<marker> inststat <name> <insts> <cycles>" and
+    # "[n] Code Region - <name>" followed by "Total Cycles: <cycles>"
+    awk -v iterations=$ITERATIONS -v cpu=$CPU -v kernel=$NAME \
+      -v csv=$PREFIX.csv '
+      FNR == NR {
+        if ($2 == "inststat") {
+          model[$3] = $5
+          order[count++] = $3
+        }
+        next
+      }
+      /Code Region - / {
+        region = $NF
+      }
+      /^Total Cycles:/ {
+        mca[region] = $3 / iterations
+      }
+      END {
+        print "block,model,llvm-mca" > csv
+
+        for (i = 0; i < count; i++) {
+          name = order[i]
+
+          if (!(name in mca)) {
+            continue
+          }
+
+          print name "," model[name] "," mca[name] > csv
+
+          sumModel += model[name]
+          sumMCA += mca[name]
+          blocks++
+
+          if (mca[name] > 0) {
+            diff = (model[name] - mca[name]) / mca[name]
+            absError += diff < 0 ? -diff : diff
+          }
+        }
+
+        printf "%-12s %-10s %7d %12d %12.2f %8.1f%% %8.1f%%\n", cpu, kernel,
+          blocks, sumModel, sumMCA,
+          (sumMCA > 0 ? (sumModel - sumMCA) * 100 / sumMCA : 0),
+          (blocks > 0 ? absError * 100 / blocks : 0)
+      }' $PREFIX.mca.S $PREFIX.mca.txt
+  done
+done
@@ -8,6 +8,7 @@
 #include "src/basic_block_collector.hh"
 
 #include <string>
+#include <tuple>
 
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Function.h"
@@ -74,7 +75,7 @@ bool BasicBlockCollector::runOnFunction(Function &func) {
     outs() << ".\n";
 #endif
 
-    std::string funcfile;
+    const DIFile *funcfile = nullptr;
     uint32_t line;
 
     // Get function info
@@ -82,11 +83,12 @@ bool BasicBlockCollector::runOnFunction(Function &func) {
 
     // Write function name
     outfile << "func: " << func.getName().data() << std::endl;
-    outfile << " at: " << funcfile << ":" << line << std::endl;
+    outfile << " at: " << (funcfile ? funcfile->getFilename().str() : "")
+            << ":" << line << std::endl;
 
     for (auto &block : func) {
-      std::vector<uint32_t> linelist;
-      std::string file;
+      std::vector<std::pair<const DIFile *, uint32_t>> linelist;
+      const DIFile *file;
 
       // Filter blocks by name
       /// All blocks begins with dot (.)
@@ -114,12 +116,13 @@ bool BasicBlockCollector::runOnFunction(Function &func) {
       // Reserve for performance
       linelist.reserve(block.size());
 
-      // Write all line information if line info is valid + same module
+      // Write all line information if line info is valid, including lines
+      // of code inlined from other files
       for (auto &inst : block) {
         line = getLineInfo(inst, file);
 
-        if (line > 0 && file.compare(funcfile) == 0) {
-          linelist.emplace_back(line);
+        if (line > 0) {
+          linelist.emplace_back(file, line);
         }
       }
 
@@ -128,8 +131,17 @@ bool BasicBlockCollector::runOnFunction(Function &func) {
         continue;
       }
 
-      // Sort
-      std::sort(linelist.begin(), linelist.end());
+      // Sort, lines of function file first
+      auto order = [funcfile](const std::pair<const DIFile *, uint32_t> &v) {
+        return std::make_tuple(v.first != funcfile, v.first->getFilename(),
+                               v.second, v.first);
+      };
+
+      std::sort(linelist.begin(), linelist.end(),
+                [&order](const std::pair<const DIFile *, uint32_t> &a,
+                         const std::pair<const DIFile *, uint32_t> &b) {
+                  return order(a) < order(b);
+                });
 
       // Unique
       auto end = std::unique(linelist.begin(), linelist.end());
@@ -138,7 +150,13 @@ bool BasicBlockCollector::runOnFunction(Function &func) {
       outfile << " block: " << block.getName().data() << std::endl;
 
       for (auto iter = linelist.begin(); iter != end; ++iter) {
-        outfile << "  " << *iter << ":" << std::endl;
+        if (iter->first == funcfile) {
+          outfile << "  " << iter->second << ":" << std::endl;
+        }
+        else {
+          outfile << "  " << iter->first->getFilename().str() << ":"
+                  << iter->second << ":" << std::endl;
+        }
       }
     }
 
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_DATABASE_FORMAT_HH__
+#define __SRC_DATABASE_FORMAT_HH__
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
+
+/**
+ * Cost database file layout (native endian, all offsets from file begin)
+ *
+ *  Header
+ *  Module[modules]
+ *  Function[functions]      Functions of same module are contiguous
+ *  Block[blocks]            Blocks of same function are contiguous
+ *  uint32_t[functionSlots]  Open addressing table (index + 1, 0 = empty)
+ *  uint32_t[blockSlots]     Open addressing table (index + 1, 0 = empty)
+ *  char[stringSize]         Null-terminated names
+ */
+
+#define DB_MAGIC "INSTSTAT"
+#define DB_VERSION 1
+#define DB_COST_COUNT 7  // Same order with inststat file
+
+namespace SimpleSSD::LLVM::DB {
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t modules;
+  uint32_t functions;
+  uint32_t blocks;
+  uint32_t functionSlots;  // Power of two
+  uint32_t blockSlots;     // Power of two
+
+  uint64_t moduleOffset;
+  uint64_t functionOffset;
+  uint64_t blockOffset;
+  uint64_t functionSlotOffset;
+  uint64_t blockSlotOffset;
+  uint64_t stringOffset;
+  uint64_t stringSize;
+};
+
+struct Module {
+  uint32_t name;
+  uint32_t firstFunction;
+  uint32_t functions;
+  uint32_t reserved;
+};
+
+struct Function {
+  uint64_t hash;
+  uint32_t name;
+  uint32_t module;
+  uint32_t firstBlock;
+  uint32_t blocks;
+
+  uint64_t cost[DB_COST_COUNT];  // Sum of blocks
+};
+
+struct Block {
+  uint64_t hash;  // hashName(block, hashName(function))
+  uint32_t name;
+  uint32_t function;
+
+  uint64_t cost[DB_COST_COUNT];
+};
+
+//! FNV-1a
+inline uint64_t hashName(const char *str,
+                         uint64_t seed = 0xcbf29ce484222325ull) {
+  for (; *str; str++) {
+    seed ^= (uint8_t)*str;
+    seed *= 0x100000001b3ull;
+  }
+
+  return seed;
+}
+
+/**
+ * \brief Validated view of database image
+ */
+class View {
+ private:
+  const uint8_t *base;
+  size_t size;
+
+  bool check(uint64_t offset, uint64_t count, size_t unit) const {
+    return offset % 8 == 0 && offset <= size && count <= (size - offset) / unit;
+  }
+
+ public:
+  View() : base(nullptr), size(0) {}
+
+  bool init(const void *data, size_t length) {
+    base = (const uint8_t *)data;
+    size = length;
+
+    if (size < sizeof(Header)) {
+      return false;
+    }
+
+    auto &h = header();
+
+    if (memcmp(h.magic, DB_MAGIC, 8) != 0 || h.version != DB_VERSION) {
+      return false;
+    }
+
+    if ((h.functionSlots & (h.functionSlots - 1)) != 0 ||
+        (h.blockSlots & (h.blockSlots - 1)) != 0) {
+      return false;
+    }
+
+    return check(h.moduleOffset, h.modules, sizeof(Module)) &&
+           check(h.functionOffset, h.functions, sizeof(Function)) &&
+           check(h.blockOffset, h.blocks, sizeof(Block)) &&
+           check(h.functionSlotOffset, h.functionSlots, sizeof(uint32_t)) &&
+           check(h.blockSlotOffset, h.blockSlots, sizeof(uint32_t)) &&
+           h.stringOffset <= size && h.stringSize <= size - h.stringOffset &&
+           (h.stringSize == 0 || base[h.stringOffset + h.stringSize - 1] == 0);
+  }
+
+  const Header &header() const { return *(const Header *)base; }
+
+  const Module *modules() const {
+    return (const Module *)(base + header().moduleOffset);
+  }
+  const Function *functions() const {
+    return (const Function *)(base + header().functionOffset);
+  }
+  const Block *blocks() const {
+    return (const Block *)(base + header().blockOffset);
+  }
+  const uint32_t *functionSlots() const {
+    return (const uint32_t *)(base + header().functionSlotOffset);
+  }
+  const uint32_t *blockSlots() const {
+    return (const uint32_t *)(base + header().blockSlotOffset);
+  }
+
+  const char *string(uint32_t offset) const {
+    if (offset >= header().stringSize) {
+      return "";
+    }
+
+    return (const char *)(base + header().stringOffset + offset);
+  }
+};
+
+}  // namespace SimpleSSD::LLVM::DB
+
+#endif
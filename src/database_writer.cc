@@ -0,0 +1,275 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/database_writer.hh"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+
+namespace SimpleSSD::LLVM::DB {
+
+namespace {
+
+using ModuleList = std::map<std::string, std::vector<FunctionCost>>;
+
+void loadModules(const std::string &path, ModuleList &list) {
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file.is_open()) {
+    return;
+  }
+
+  std::vector<char> image((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+  View view;
+
+  // Broken or old database is just overwritten
+  if (!view.init(image.data(), image.size())) {
+    return;
+  }
+
+  auto &header = view.header();
+
+  for (uint32_t m = 0; m < header.modules; m++) {
+    auto &module = view.modules()[m];
+    auto &funclist = list[view.string(module.name)];
+
+    if (module.firstFunction > header.functions ||
+        module.functions > header.functions - module.firstFunction) {
+      continue;
+    }
+
+    for (uint32_t f = 0; f < module.functions; f++) {
+      auto &func = view.functions()[module.firstFunction + f];
+
+      funclist.emplace_back(FunctionCost());
+      funclist.back().name = view.string(func.name);
+
+      if (func.firstBlock > header.blocks ||
+          func.blocks > header.blocks - func.firstBlock) {
+        continue;
+      }
+
+      for (uint32_t b = 0; b < func.blocks; b++) {
+        auto &block = view.blocks()[func.firstBlock + b];
+        BlockCost cost;
+
+        cost.name = view.string(block.name);
+        memcpy(cost.cost, block.cost, sizeof(cost.cost));
+
+        funclist.back().blocks.emplace_back(std::move(cost));
+      }
+    }
+  }
+}
+
+uint32_t getSlots(uint32_t count) {
+  uint32_t slots = 1;
+
+  // Keep load factor under 0.5
+  while (slots < count * 2) {
+    slots <<= 1;
+  }
+
+  return slots;
+}
+
+uint64_t align(uint64_t offset) {
+  return (offset + 7) & ~(uint64_t)7;
+}
+
+void insertSlot(std::vector<uint32_t> &slots, uint64_t hash, uint32_t idx) {
+  uint32_t mask = slots.size() - 1;
+
+  for (uint32_t i = 0;; i++) {
+    auto &slot = slots[(hash + i) & mask];
+
+    if (slot == 0) {
+      slot = idx + 1;
+
+      break;
+    }
+  }
+}
+
+bool saveModules(const std::string &path, ModuleList &list) {
+  Header header;
+  std::vector<Module> modules;
+  std::vector<Function> functions;
+  std::vector<Block> blocks;
+  std::string strings;
+  std::unordered_map<std::string, uint32_t> stringIndex;
+
+  auto addString = [&](const std::string &str) -> uint32_t {
+    auto ret = stringIndex.emplace(str, strings.size());
+
+    if (ret.second) {
+      strings.append(str);
+      strings.push_back('\0');
+    }
+
+    return ret.first->second;
+  };
+
+  for (auto &iter : list) {
+    Module module;
+
+    module.name = addString(iter.first);
+    module.firstFunction = functions.size();
+    module.functions = iter.second.size();
+    module.reserved = 0;
+
+    for (auto &func : iter.second) {
+      Function entry;
+
+      entry.hash = hashName(func.name.c_str());
+      entry.name = addString(func.name);
+      entry.module = modules.size();
+      entry.firstBlock = blocks.size();
+      entry.blocks = func.blocks.size();
+      memset(entry.cost, 0, sizeof(entry.cost));
+
+      for (auto &block : func.blocks) {
+        Block bentry;
+
+        bentry.hash = hashName(block.name.c_str(), entry.hash);
+        bentry.name = addString(block.name);
+        bentry.function = functions.size();
+        memcpy(bentry.cost, block.cost, sizeof(bentry.cost));
+
+        for (uint32_t i = 0; i < DB_COST_COUNT; i++) {
+          entry.cost[i] += block.cost[i];
+        }
+
+        blocks.emplace_back(bentry);
+      }
+
+      functions.emplace_back(entry);
+    }
+
+    modules.emplace_back(module);
+  }
+
+  // Hash tables, filled in module order
+  std::vector<uint32_t> functionSlots(getSlots(functions.size()), 0);
+  std::vector<uint32_t> blockSlots(getSlots(blocks.size()), 0);
+
+  for (uint32_t i = 0; i < functions.size(); i++) {
+    insertSlot(functionSlots, functions[i].hash, i);
+  }
+  for (uint32_t i = 0; i < blocks.size(); i++) {
+    insertSlot(blockSlots, blocks[i].hash, i);
+  }
+
+  // Layout
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DB_MAGIC, 8);
+  header.version = DB_VERSION;
+  header.modules = modules.size();
+  header.functions = functions.size();
+  header.blocks = blocks.size();
+  header.functionSlots = functionSlots.size();
+  header.blockSlots = blockSlots.size();
+
+  header.moduleOffset = align(sizeof(Header));
+  header.functionOffset =
+      align(header.moduleOffset + modules.size() * sizeof(Module));
+  header.blockOffset =
+      align(header.functionOffset + functions.size() * sizeof(Function));
+  header.functionSlotOffset =
+      align(header.blockOffset + blocks.size() * sizeof(Block));
+  header.blockSlotOffset = align(header.functionSlotOffset +
+                                 functionSlots.size() * sizeof(uint32_t));
+  header.stringOffset =
+      align(header.blockSlotOffset + blockSlots.size() * sizeof(uint32_t));
+  header.stringSize = strings.size();
+
+  std::vector<uint8_t> image(header.stringOffset + header.stringSize, 0);
+
+  auto put = [&image](uint64_t offset, const void *data, size_t size) {
+    if (size > 0) {
+      memcpy(image.data() + offset, data, size);
+    }
+  };
+
+  put(0, &header, sizeof(header));
+  put(header.moduleOffset, modules.data(), modules.size() * sizeof(Module));
+  put(header.functionOffset, functions.data(),
+      functions.size() * sizeof(Function));
+  put(header.blockOffset, blocks.data(), blocks.size() * sizeof(Block));
+  put(header.functionSlotOffset, functionSlots.data(),
+      functionSlots.size() * sizeof(uint32_t));
+  put(header.blockSlotOffset, blockSlots.data(),
+      blockSlots.size() * sizeof(uint32_t));
+  put(header.stringOffset, strings.data(), strings.size());
+
+  // Write to temporal file and replace
+  std::string temp = path + ".tmp." + std::to_string(getpid());
+  std::ofstream file(temp, std::ios::binary);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file.write((const char *)image.data(), image.size());
+  file.close();
+
+  if (!file.good()) {
+    unlink(temp.c_str());
+
+    return false;
+  }
+
+  if (rename(temp.c_str(), path.c_str()) != 0) {
+    unlink(temp.c_str());
+
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+bool updateDatabase(const std::string &path, const std::string &module,
+                    const std::vector<FunctionCost> &list) {
+  std::string lockpath = path + ".lock";
+  int lock = open(lockpath.c_str(), O_RDWR | O_CREAT, 0644);
+
+  if (lock < 0) {
+    return false;
+  }
+
+  if (flock(lock, LOCK_EX) != 0) {
+    close(lock);
+
+    return false;
+  }
+
+  ModuleList modules;
+
+  loadModules(path, modules);
+
+  modules[module] = list;
+
+  bool ret = saveModules(path, modules);
+
+  flock(lock, LOCK_UN);
+  close(lock);
+
+  return ret;
+}
+
+}  // namespace SimpleSSD::LLVM::DB
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_DATABASE_WRITER_HH__
+#define __SRC_DATABASE_WRITER_HH__
+
+#include <string>
+#include <vector>
+
+#include "src/database_format.hh"
+
+namespace SimpleSSD::LLVM::DB {
+
+struct BlockCost {
+  std::string name;
+  uint64_t cost[DB_COST_COUNT];
+};
+
+struct FunctionCost {
+  std::string name;
+  std::vector<BlockCost> blocks;
+};
+
+/**
+ * \brief Replace section of one module in cost database
+ *
+ * Database is created if not exists. Concurrent writers (parallel build) are
+ * serialized by lock file (<path>.lock), and new image is renamed over old
+ * one, so readers always see complete database.
+ */
+bool updateDatabase(const std::string &, const std::string &,
+                    const std::vector<FunctionCost> &);
+
+}  // namespace SimpleSSD::LLVM::DB
+
+#endif
@@ -12,4 +12,32 @@
 #define IA_FILE_POSTFIX ".inststat.txt"
 #define ASM_FILE_POSTFIX ".S"
 
+// Runtime symbols (see src/runtime)
+#define RT_SHARD_TLS "__inststat_shard"
+#define RT_SHARD_CAPACITY "__inststat_shard_capacity"
+#define RT_SHARD_ACQUIRE "__inststat_shard_acquire"
+#define RT_SHARD_REGISTER "__inststat_shard_register"
+#define RT_SHARD_SLOT_SIZE 8  // uint64_t per function, one cache line
+#define RT_SAMPLE_REGISTER "__inststat_sample_register"
+#define RT_SAMPLE_RECORD "__inststat_sample_record"
+#define RT_SWITCH_FLAG "__inststat_enabled"
+#define RT_UPDATE_COUNT "__inststat_updates"
+#define RT_PROFILE_REGISTER "__inststat_profile_register"
+#define RT_TRACE_REGISTER "__inststat_trace_register"
+#define RT_TRACE_CLOCK "__inststat_trace_clock"
+#define RT_TRACE_RECORD "__inststat_trace_record"
+#define RT_BRANCH_REGISTER "__inststat_branch_register"
+#define RT_BRANCH_RECORD "__inststat_branch"
+#define RT_INDIRECT_RECORD "__inststat_indirect"
+#define RT_CACHE_BUFFER "__inststat_cache_buffer"
+#define RT_CACHE_COUNT "__inststat_cache_count"
+#define RT_CACHE_FLUSH "__inststat_cache_flush"
+#define RT_CACHE_BUFFER_SIZE 1024  // Accesses per thread
+#define RT_CACHE_BATCH 64          // Max accesses between buffer checks
+#define RT_CPU_REGISTER "__inststat_cpu_register"
+#define RT_HISTOGRAM_REGISTER "__inststat_histogram_register"
+#define RT_HISTOGRAM_SUB_BITS 5  // 32 linear buckets per power of two
+#define RT_HISTOGRAM_BUCKETS \
+  ((64 - RT_HISTOGRAM_SUB_BITS + 1) << RT_HISTOGRAM_SUB_BITS)
+
 #endif
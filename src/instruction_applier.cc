@@ -7,17 +7,33 @@
 
 #include "src/instruction_applier.hh"
 
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
 #include <regex>
 #include <string>
+#include <unordered_set>
 
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include "src/spanning_tree.hh"
 
 #define DEBUG_TYPE "SimpleSSD::LLVM::InstructionApplier"
 
@@ -28,90 +44,1901 @@ static cl::opt<std::string> inputFile(
     cl::desc("Input file prefix of SimpleSSD instruction statistics"),
     cl::value_desc("filename"), cl::init(""));
 
+static cl::opt<bool> edgeProfile(
+    "inststat-edge-profile",
+    cl::desc("Only count spanning tree chords and reconstruct block counts "
+             "at function exit (functions with calls which may throw or not "
+             "return use per-block counters)"),
+    cl::init(false));
+
+static cl::opt<bool> shard(
+    "inststat-shard",
+    cl::desc("Update per-thread counter shards instead of CPU::Function"),
+    cl::init(false));
+
+static cl::opt<uint32_t> sampleRate(
+    "inststat-sample",
+    cl::desc("Only count every N-th invocation of marked functions"),
+    cl::value_desc("N"), cl::init(0));
+
+static cl::opt<bool> runtimeSwitch(
+    "inststat-switch",
+    cl::desc("Keep uninstrumented copy of marked functions, selected at "
+             "runtime by Runtime::setInstrumentation"),
+    cl::init(false));
+
+static cl::opt<bool> inclusive(
+    "inststat-inclusive",
+    cl::desc("Add static cost of unmarked callees at each call remaining "
+             "in assembly"),
+    cl::init(false));
+
+static cl::opt<bool> expectedCost(
+    "inststat-expected",
+    cl::desc("Add expected cost of marked functions once at entry, using "
+             "block frequencies (profile data via branch_weights metadata)"),
+    cl::init(false));
+
+static cl::opt<bool> trace(
+    "inststat-trace",
+    cl::desc("Record cycles of each invocation of marked functions to "
+             "per-thread trace buffer"),
+    cl::init(false));
+
+static cl::opt<bool> histogram(
+    "inststat-histogram",
+    cl::desc("Count cycles of each invocation of marked functions in "
+             "log-linear histogram"),
+    cl::init(false));
+
+static cl::opt<bool> branchModel(
+    "inststat-branch",
+    cl::desc("Report outcome of conditional and indirect branches of marked "
+             "functions to runtime branch predictor model"),
+    cl::init(false));
+
+static cl::opt<bool> cacheModel(
+    "inststat-cache",
+    cl::desc("Simulate data cache with addresses of loads and stores of "
+             "marked functions, and add stall cycles"),
+    cl::init(false));
+
+static cl::opt<bool> multiCPU(
+    "inststat-multicpu",
+    cl::desc("Keep cost of every CPU model of statistic file in constant "
+             "table, selected at runtime by Runtime::setCPUModel (per-block "
+             "updates, edge profile is not used)"),
+    cl::init(false));
+
+static cl::opt<bool> memoryCost(
+    "inststat-memory",
+    cl::desc("Add cycles of memcpy, memmove and memset of marked functions "
+             "from their length argument"),
+    cl::init(false));
+
+static cl::opt<uint32_t> memoryInline(
+    "inststat-memory-inline",
+    cl::desc("Intrinsics with constant length up to N bytes are expanded "
+             "inline by backend, and already counted"),
+    cl::value_desc("N"), cl::init(128));
+
+static cl::opt<bool> coverageReport(
+    "inststat-report",
+    cl::desc("Write matching quality of marked functions (assembly cycles "
+             "applied to IR) to <statistic file>.coverage.csv"),
+    cl::init(false));
+
+static cl::opt<uint32_t> minCoverage(
+    "inststat-min-coverage",
+    cl::desc("Fail if less than N percent of assembly cycles of marked "
+             "functions are applied to IR (0 = no check)"),
+    cl::value_desc("N"), cl::init(0));
+
+static cl::opt<bool> countUpdates(
+    "inststat-count-updates",
+    cl::desc("Count executed counter updates (including edge profile chord "
+             "increments) in runtime, for overhead benchmark"),
+    cl::init(false), cl::Hidden);
+
+static cl::opt<bool> blockProfile(
+    "inststat-block-profile",
+    cl::desc("Count executions of each basic block of marked functions"),
+    cl::init(false));
+
+static cl::opt<SimpleSSD::LLVM::Level> level(
+    "inststat-level", cl::desc("Counters of CPU::Function to be updated"),
+    cl::values(clEnumValN(SimpleSSD::LLVM::Level::None, "none",
+                          "Remove marker only"),
+               clEnumValN(SimpleSSD::LLVM::Level::Cycles, "cycles",
+                          "Cycles only"),
+               clEnumValN(SimpleSSD::LLVM::Level::Categories, "categories",
+                          "Cycles, branch, load and store"),
+               clEnumValN(SimpleSSD::LLVM::Level::Full, "full",
+                          "All counters")),
+    cl::init(SimpleSSD::LLVM::Level::Full));
+
 namespace SimpleSSD::LLVM {
 
-InstructionApplier::InstructionApplier() : FunctionPass(ID), inited(false) {
-#if DEBUG_MODE
-  outs() << "SimpleSSD instruction statistic applier.\n";
-#endif
-}
+// Library routines whose cost scales with length argument (memcmp may stop
+// at first difference, so it is not included)
+static const struct {
+  const char *name;
+  uint32_t length;  // Index of length argument
+  bool set;         // Only stores (memset), otherwise copy
+} routines[] = {
+    {"memcpy", 2, false},           {"memmove", 2, false},
+    {"memset", 2, true},            {"bzero", 1, true},
+    {"__aeabi_memcpy", 2, false},   {"__aeabi_memcpy4", 2, false},
+    {"__aeabi_memcpy8", 2, false},  {"__aeabi_memmove", 2, false},
+    {"__aeabi_memmove4", 2, false}, {"__aeabi_memmove8", 2, false},
+    {"__aeabi_memset", 1, true},    {"__aeabi_memset4", 1, true},
+    {"__aeabi_memset8", 1, true},   {"__aeabi_memclr", 1, true},
+    {"__aeabi_memclr4", 1, true},   {"__aeabi_memclr8", 1, true},
+};
+
+static bool isMaterialized(uint32_t counter) {
+  switch (level) {
+    case Level::Cycles:
+      return counter == Counter::Cycles;
+    case Level::Categories:
+      return counter == Counter::Cycles || counter == Counter::Branch ||
+             counter == Counter::Load || counter == Counter::Store;
+    case Level::Full:
+      return true;
+    default:
+      return false;
+  }
+}
+
+InstructionApplier::InstructionApplier()
+    : FunctionPass(ID),
+      inited(false),
+      vectorCounter(false),
+      ctor(nullptr),
+      cpuModel(nullptr),
+      memoryTable(nullptr) {
+#if DEBUG_MODE
+  outs() << "SimpleSSD instruction statistic applier.\n";
+#endif
+}
+
+const char *InstructionApplier::getFileName(const DIFile *file) {
+  auto iter = files.find(file);
+
+  if (iter == files.end()) {
+    auto name = strings->save(file ? file->getFilename() : "").data();
+
+    iter = files.insert(std::make_pair(file, name)).first;
+  }
+
+  return iter->second;
+}
+
+void InstructionApplier::makePointers(Instruction *next, Value *fstat,
+                                      StructType *type) {
+  // %ptr = getelementptr inbounds %"class.SimpleSSD::CPU::Function",
+  // %"class.SimpleSSD::CPU::Function"* %fstat, i32 0, i32 %idx
+
+  static const char *names[Counter::CounterCount] = {
+      "fstat_branch", "fstat_load",  "fstat_store",  "fstat_arithmetic",
+      "fstat_floating", "fstat_other", "fstat_cycles", "fstat_vector",
+  };
+
+  // Create builder
+  IRBuilder<> builder(next);
+
+  for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+    // Only make pointers of counters we update
+    if (!isMaterialized(i) || (i == Counter::Vector && !vectorCounter)) {
+      pointers[i] = nullptr;
+
+      continue;
+    }
+
+    // IdxList
+    Value *idxList[2] = {builder.getInt32(0), builder.getInt32(i)};
+
+    // Add instructions
+    pointers[i] = builder.CreateInBoundsGEP(
+        type, fstat, ArrayRef<Value *>(idxList, 2), names[i]);
+  }
+}
+
+void InstructionApplier::makeShardPointers(Instruction *next) {
+  // %slot = load i32, i32* @inststat.shard.<func>
+  // if (%slot >= @__inststat_shard_capacity)
+  //   %shard = call i64* @__inststat_shard_acquire()
+  // %ptr = getelementptr inbounds i64, i64* %shard, i64 %slot * 8 + %idx
+
+  static const char *names[Counter::CounterCount] = {
+      "shard_branch", "shard_load",  "shard_store",  "shard_arithmetic",
+      "shard_floating", "shard_other", "shard_cycles", "shard_vector",
+  };
+
+  auto &module = *next->getModule();
+  IRBuilder<> builder(next);
+
+  auto i64ptr = builder.getInt64Ty()->getPointerTo();
+  auto tls = module.getGlobalVariable(RT_SHARD_TLS);
+  auto capacity = module.getGlobalVariable(RT_SHARD_CAPACITY);
+
+  if (tls == nullptr) {
+    tls = new GlobalVariable(module, i64ptr, false,
+                             GlobalValue::ExternalLinkage, nullptr,
+                             RT_SHARD_TLS, nullptr,
+                             GlobalValue::InitialExecTLSModel);
+  }
+
+  if (capacity == nullptr) {
+    capacity = new GlobalVariable(module, builder.getInt32Ty(), false,
+                                  GlobalValue::ExternalLinkage, nullptr,
+                                  RT_SHARD_CAPACITY, nullptr,
+                                  GlobalValue::InitialExecTLSModel);
+  }
+
+  // Slot of current function, filled by module constructor
+  auto func = next->getFunction();
+  auto slot = new GlobalVariable(
+      module, builder.getInt32Ty(), false, GlobalValue::InternalLinkage,
+      builder.getInt32(0), "inststat.shard." + func->getName());
+
+  IRBuilder<> ctorBuilder(getCtor(module));
+  auto reg = module.getOrInsertFunction(RT_SHARD_REGISTER,
+                                        builder.getInt32Ty(),
+                                        builder.getInt8PtrTy());
+
+  ctorBuilder.CreateStore(
+      ctorBuilder.CreateCall(
+          reg, ctorBuilder.CreateGlobalStringPtr(func->getName())),
+      slot);
+
+  // Capacity is zero before first call of each thread, and smaller than slot
+  // when function is registered after shard of current thread is allocated
+  auto head = next->getParent();
+  auto index = builder.CreateLoad(builder.getInt32Ty(), slot, "slot");
+  auto base = builder.CreateLoad(i64ptr, tls, "shard");
+  auto full = builder.CreateICmpUGE(
+      index, builder.CreateLoad(builder.getInt32Ty(), capacity), "noslot");
+
+  auto weights = MDBuilder(module.getContext()).createBranchWeights(1, 1 << 20);
+  auto then = SplitBlockAndInsertIfThen(full, next, false, weights);
+
+  IRBuilder<> acquireBuilder(then);
+  auto acquire = module.getOrInsertFunction(RT_SHARD_ACQUIRE, i64ptr);
+  auto fresh = acquireBuilder.CreateCall(acquire);
+
+  builder.SetInsertPoint(next);
+
+  auto phi = builder.CreatePHI(i64ptr, 2, "shard");
+
+  phi->addIncoming(base, head);
+  phi->addIncoming(fresh, then->getParent());
+
+  auto offset =
+      builder.CreateMul(builder.CreateZExt(index, builder.getInt64Ty()),
+                        builder.getInt64(RT_SHARD_SLOT_SIZE));
+
+  for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+    if (!isMaterialized(i) || (i == Counter::Vector && !vectorCounter)) {
+      pointers[i] = nullptr;
+
+      continue;
+    }
+
+    pointers[i] = builder.CreateInBoundsGEP(
+        builder.getInt64Ty(), phi,
+        builder.CreateAdd(offset, builder.getInt64(i)), names[i]);
+  }
+}
+
+Instruction *InstructionApplier::getCtor(Module &module) {
+  if (ctor == nullptr) {
+    auto type = FunctionType::get(Type::getVoidTy(module.getContext()), false);
+
+    ctor = Function::Create(type, GlobalValue::InternalLinkage,
+                            "inststat.ctor", &module);
+
+    auto entry = BasicBlock::Create(module.getContext(), "entry", ctor);
+
+    ReturnInst::Create(module.getContext(), entry);
+
+    // Run before any other static initializer
+    appendToGlobalCtors(module, ctor, 1);
+  }
+
+  return &ctor->getEntryBlock().back();
+}
+
+GlobalVariable *InstructionApplier::getCPUModel(Module &module) {
+  // @inststat.cpu = internal global i32 0
+  // @inststat.cpu.names = private constant [M x i8*] (models of file)
+  // Constructor: __inststat_cpu_register(names, M, @inststat.cpu)
+
+  if (cpuModel == nullptr) {
+    IRBuilder<> ctorBuilder(getCtor(module));
+
+    auto i32 = ctorBuilder.getInt32Ty();
+
+    cpuModel = new GlobalVariable(module, i32, false,
+                                  GlobalValue::InternalLinkage,
+                                  ctorBuilder.getInt32(0), "inststat.cpu");
+
+    std::vector<Constant *> names;
+
+    for (auto name : models) {
+      names.emplace_back(ctorBuilder.CreateGlobalStringPtr(name));
+    }
+
+    auto namesType = ArrayType::get(ctorBuilder.getInt8PtrTy(), names.size());
+    auto table = new GlobalVariable(module, namesType, true,
+                                    GlobalValue::PrivateLinkage,
+                                    ConstantArray::get(namesType, names),
+                                    "inststat.cpu.names");
+
+    auto reg = module.getOrInsertFunction(
+        RT_CPU_REGISTER, ctorBuilder.getVoidTy(),
+        ctorBuilder.getInt8PtrTy()->getPointerTo(), i32, i32->getPointerTo());
+
+    ctorBuilder.CreateCall(
+        reg, {ctorBuilder.CreateConstInBoundsGEP2_32(namesType, table, 0, 0),
+              ctorBuilder.getInt32(names.size()), cpuModel});
+  }
+
+  return cpuModel;
+}
+
+void InstructionApplier::makeAdd(llvm::Instruction *next, Value *target,
+                                 uint64_t value) {
+  IRBuilder<> builder(next);
+
+  makeAdd(next, target, builder.getInt64(value));
+}
+
+void InstructionApplier::makeAdd(llvm::Instruction *next, Value *target,
+                                 Value *value) {
+  // %reg = load i64, i64* %target, align 8
+  // %add = add i64 %reg, %value
+  // store i64 %add, i64* %target, align 8
+
+  // Create builder
+  IRBuilder<> builder(next);
+
+  // Load
+  auto load = builder.CreateLoad(builder.getInt64Ty(), target);
+#if LLVM_VERSION_MAJOR >= 10
+  load->setAlignment(Align(8));
+#else
+  load->setAlignment(8);
+#endif
+
+  // Add
+  auto add = builder.CreateAdd(value, load);
+
+  // Store
+  auto store = builder.CreateStore(add, target);
+#if LLVM_VERSION_MAJOR >= 10
+  store->setAlignment(Align(8));
+#else
+  store->setAlignment(8);
+#endif
+
+  makeUpdateCount(next);
+}
+
+void InstructionApplier::makeUpdateCount(Instruction *next) {
+  // __inststat_updates++, for -inststat-count-updates
+  if (!countUpdates) {
+    return;
+  }
+
+  auto &module = *next->getModule();
+  IRBuilder<> builder(next);
+  auto count = module.getGlobalVariable(RT_UPDATE_COUNT);
+
+  if (count == nullptr) {
+    count = new GlobalVariable(module, builder.getInt64Ty(), false,
+                               GlobalValue::ExternalLinkage, nullptr,
+                               RT_UPDATE_COUNT);
+  }
+
+  builder.CreateStore(
+      builder.CreateAdd(builder.CreateLoad(builder.getInt64Ty(), count),
+                        builder.getInt64(1)),
+      count);
+}
+
+void InstructionApplier::collectBlockStats(
+    Function &func, FuncStat &funcstat, uint32_t model,
+    std::unordered_map<BasicBlock *, LineStat> &blockstats,
+    Coverage *coverage) {
+  auto &lines = funcstat.lines[model];
+  auto &calls = funcstat.calls[model];
+  const DIFile *file;
+  uint32_t line;
+
+  if (coverage) {
+    for (auto &stat : lines) {
+      coverage->statCycles += stat.second.cycles;
+    }
+  }
+
+  // Same line may be inlined to multiple call sites - split its cost
+  DenseMap<LineKey, SmallPtrSet<const DILocation *, 2>> sites;
+
+  for (auto &block : func) {
+    for (auto &inst : block) {
+      line = getLineInfo(inst, file);
+
+      if (line > 0) {
+        sites[LineKey(getFileName(file), line)].insert(getInlinedSite(inst));
+      }
+    }
+  }
+
+  // Collect instruction stats ...
+  for (auto &block : func) {
+    // Total stat of current basic block
+    LineStat sum;
+    LineStat callees;
+
+    // ... from each lines
+    for (auto &inst : block) {
+      // Get line info
+      line = getLineInfo(inst, file);
+
+      if (line == 0) {
+        continue;
+      }
+
+      // Find line from database
+      LineKey key(getFileName(file), line);
+      auto stat = lines.find(key);
+      auto call = inclusive ? calls.find(key) : calls.end();
+
+      if (stat == lines.end() && call == calls.end()) {
+        continue;
+      }
+
+      // Charge once per call site
+      auto &pending = sites[key];
+
+      if (pending.erase(getInlinedSite(inst))) {
+        if (stat != lines.end()) {
+          sum += stat->second.split(pending.size() + 1);
+        }
+
+        if (call != calls.end()) {
+          callees += call->second.split(pending.size() + 1);
+        }
+      }
+    }
+
+    bool range = false;
+
+    if (sum.cycles == 0) {
+      // Current block does not have line information, use old method
+      uint32_t begin = getFirstLine(block, file);
+      uint32_t end = getLastLine(block, file);
+      uint32_t idx;
+
+      if (funcstat.ranges.find(begin, end, idx)) {
+        for (auto &bbline : funcstat.blocks[idx].lines) {
+          auto bblinestat = lines.find(bbline);
+
+          if (bblinestat != lines.end()) {
+            // Sum stat value to sum
+            sum += bblinestat->second;
+
+            bblinestat->second = LineStat();
+          }
+        }
+
+        range = sum.cycles > 0;
+      }
+    }
+
+    if (coverage) {
+      coverage->blocks++;
+      coverage->appliedCycles += sum.cycles;
+
+      if (range) {
+        coverage->rangeBlocks++;
+      }
+      else if (sum.cycles > 0) {
+        coverage->lineBlocks++;
+      }
+      else {
+        coverage->unmatchedBlocks++;
+      }
+    }
+
+    // Add static cost of unmarked callees
+    sum += callees;
+
+    if (coverage) {
+      coverage->calleeCycles += callees.cycles;
+    }
+
+    if (sum.cycles == 0) {
+      // Giving up
+      continue;
+    }
+
+    // Log result of primary model if possible
+    if (resultfile.is_open() && model == 0) {
+      resultfile << " BasicBlock: " << block.getName().data() << std::endl;
+      resultfile << "  Stat: " << sum.branch << ", " << sum.load << ", "
+                 << sum.store << ", " << sum.arithmetic << ", "
+                 << sum.floatingPoint << ", " << sum.otherInsts << ", "
+                 << sum.cycles << ", " << sum.vector << std::endl;
+    }
+
+    if (!vectorCounter) {
+      sum.otherInsts += sum.vector;
+      sum.vector = 0;
+    }
+
+    // Drop counters we do not update
+    for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+      if (!isMaterialized(i)) {
+        sum[i] = 0;
+      }
+    }
+
+    blockstats.emplace(&block, sum);
+  }
+
+  // Charged lines are consumed - remainder is not attributed to any block
+  if (coverage) {
+    for (auto &stat : lines) {
+      if (stat.second.cycles > 0) {
+        coverage->unmatchedLines++;
+        coverage->unmatchedCycles += stat.second.cycles;
+      }
+    }
+  }
+}
+
+void InstructionApplier::applyBlock(BasicBlock &block, LineStat &sum) {
+  // Where we need to insert stats
+  auto &last = block.back();
+
+  for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+    if (sum[i] > 0 && pointers[i]) {
+      makeAdd(&last, pointers[i], sum[i]);
+    }
+  }
+}
+
+void InstructionApplier::applyCostTable(
+    Function &func,
+    std::vector<std::unordered_map<BasicBlock *, LineStat>> &costs) {
+  // @table = private constant [N x [M x [C x i64]]] (block, model, counter)
+  // Each block: %cpu = load i32, i32* @inststat.cpu
+  //             counter += table[block][%cpu][counter]
+  // Counters with same cost in every model are added as immediate
+
+  auto &module = *func.getParent();
+  auto i64 = Type::getInt64Ty(func.getContext());
+  std::vector<BasicBlock *> blocks;
+  std::vector<std::vector<LineStat>> values;
+
+  for (auto &block : func) {
+    bool found = false;
+
+    values.emplace_back(costs.size());
+
+    for (uint32_t m = 0; m < costs.size(); m++) {
+      auto stat = costs[m].find(&block);
+
+      if (stat != costs[m].end()) {
+        values.back()[m] = stat->second;
+        found = true;
+      }
+    }
+
+    if (found) {
+      blocks.emplace_back(&block);
+    }
+    else {
+      values.pop_back();
+    }
+  }
+
+  if (blocks.size() == 0) {
+    return;
+  }
+
+  auto rowType = ArrayType::get(i64, Counter::CounterCount);
+  auto modelType = ArrayType::get(rowType, costs.size());
+  auto tableType = ArrayType::get(modelType, blocks.size());
+  std::vector<Constant *> rows;
+
+  for (auto &value : values) {
+    std::vector<Constant *> row;
+
+    for (auto &stat : value) {
+      SmallVector<uint64_t, Counter::CounterCount> counters;
+
+      for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+        counters.emplace_back(stat[i]);
+      }
+
+      row.emplace_back(ConstantDataArray::get(func.getContext(), counters));
+    }
+
+    rows.emplace_back(ConstantArray::get(modelType, row));
+  }
+
+  auto table = new GlobalVariable(module, tableType, true,
+                                  GlobalValue::PrivateLinkage,
+                                  ConstantArray::get(tableType, rows),
+                                  "inststat.cost." + func.getName());
+  auto cpu = getCPUModel(module);
+
+  for (uint32_t b = 0; b < blocks.size(); b++) {
+    // Where we need to insert stats
+    auto &last = blocks[b]->back();
+    auto &value = values[b];
+    IRBuilder<> builder(&last);
+
+    // Model may be changed at any time - load in each block
+    Value *index = nullptr;
+
+    for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+      if (pointers[i] == nullptr) {
+        continue;
+      }
+
+      bool same = true;
+
+      for (auto &stat : value) {
+        if (stat[i] != value.front()[i]) {
+          same = false;
+
+          break;
+        }
+      }
+
+      if (same) {
+        if (value.front()[i] > 0) {
+          makeAdd(&last, pointers[i], value.front()[i]);
+        }
+
+        continue;
+      }
+
+      if (index == nullptr) {
+        index = builder.CreateLoad(builder.getInt32Ty(), cpu);
+      }
+
+      auto ptr = builder.CreateInBoundsGEP(
+          tableType, table,
+          {builder.getInt32(0), builder.getInt32(b), index,
+           builder.getInt32(i)});
+
+      makeAdd(&last, pointers[i], builder.CreateLoad(i64, ptr));
+    }
+  }
+
+  // Log result if possible
+  if (resultfile.is_open()) {
+    resultfile << " CostTable: " << blocks.size() << " blocks, "
+               << costs.size() << " models" << std::endl;
+  }
+}
+
+LineStat InstructionApplier::getExpectedCost(
+    Function &func, std::unordered_map<BasicBlock *, LineStat> &blockstats) {
+  // Block frequency is relative to entry block, which executes once per call.
+  // BranchProbabilityInfo honors branch_weights metadata, so IR compiled with
+  // -fprofile-instr-use (or -fprofile-sample-use) gives profile-based cost.
+  auto &bfi = getAnalysis<BlockFrequencyInfoWrapperPass>().getBFI();
+  double entry = (double)bfi.getEntryFreq();
+  double values[Counter::CounterCount] = {};
+  LineStat ret;
+
+  if (entry == 0.) {
+    return ret;
+  }
+
+  for (auto &block : func) {
+    auto stat = blockstats.find(&block);
+
+    if (stat == blockstats.end()) {
+      continue;
+    }
+
+    double scale = bfi.getBlockFreq(&block).getFrequency() / entry;
+
+    for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+      values[i] += stat->second[i] * scale;
+    }
+  }
+
+  for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+    ret[i] = (uint64_t)std::llround(values[i]);
+  }
+
+  return ret;
+}
+
+void InstructionApplier::makeBlockProfile(
+    Function &func, Instruction *next,
+    std::unordered_map<BasicBlock *, LineStat> &blockstats) {
+  // @counters = internal global [N x i64] zeroinitializer
+  // @meta = private constant [N x { i8*, i32, i64 }] (name, line, cycles)
+  // Each block: counters[i] += 1
+  // Constructor: __inststat_profile_register(name, file, counters, meta, N)
+
+  auto &module = *func.getParent();
+  std::vector<BasicBlock *> region;
+
+  getRegion(next->getParent(), region);
+
+  IRBuilder<> ctorBuilder(getCtor(module));
+
+  auto i64 = ctorBuilder.getInt64Ty();
+  auto counterType = ArrayType::get(i64, region.size());
+  auto counters = new GlobalVariable(
+      module, counterType, false, GlobalValue::InternalLinkage,
+      ConstantAggregateZero::get(counterType),
+      "inststat.profile." + func.getName());
+
+  auto blockType = StructType::get(ctorBuilder.getInt8PtrTy(),
+                                   ctorBuilder.getInt32Ty(), i64);
+  std::vector<Constant *> meta;
+
+  for (uint32_t i = 0; i < region.size(); i++) {
+    auto block = region[i];
+    auto stat = blockstats.find(block);
+    const DIFile *file;
+    uint32_t line = getFirstLine(*block, file);
+    std::string name = block->getName().str();
+
+    if (name.length() == 0) {
+      name = std::to_string(i);
+    }
+
+    meta.emplace_back(ConstantStruct::get(
+        blockType, ctorBuilder.CreateGlobalStringPtr(name),
+        ctorBuilder.getInt32(line),
+        ctorBuilder.getInt64(stat != blockstats.end() ? stat->second.cycles
+                                                      : 0)));
+
+    // Count execution
+    IRBuilder<> builder(block->getTerminator());
+
+    makeAdd(block->getTerminator(),
+            builder.CreateConstInBoundsGEP2_32(counterType, counters, 0, i),
+            1);
+  }
+
+  auto metaType = ArrayType::get(blockType, region.size());
+  auto table = new GlobalVariable(module, metaType, true,
+                                  GlobalValue::PrivateLinkage,
+                                  ConstantArray::get(metaType, meta),
+                                  "inststat.profile.meta." + func.getName());
+
+  const DIFile *file = nullptr;
+
+  getLineInfo(func, file);
+
+  auto reg = module.getOrInsertFunction(
+      RT_PROFILE_REGISTER, ctorBuilder.getVoidTy(), ctorBuilder.getInt8PtrTy(),
+      ctorBuilder.getInt8PtrTy(), i64->getPointerTo(),
+      ctorBuilder.getInt8PtrTy(), ctorBuilder.getInt32Ty());
+
+  ctorBuilder.CreateCall(
+      reg, {ctorBuilder.CreateGlobalStringPtr(func.getName()),
+            ctorBuilder.CreateGlobalStringPtr(file ? file->getFilename() : ""),
+            ctorBuilder.CreateConstInBoundsGEP2_32(counterType, counters, 0, 0),
+            ctorBuilder.CreateBitCast(table, ctorBuilder.getInt8PtrTy()),
+            ctorBuilder.getInt32(region.size())});
+}
+
+void InstructionApplier::getRegion(BasicBlock *begin,
+                                   std::vector<BasicBlock *> &list) {
+  std::unordered_set<BasicBlock *> visited;
+
+  list.clear();
+  list.emplace_back(begin);
+  visited.emplace(begin);
+
+  for (uint32_t i = 0; i < list.size(); i++) {
+    for (auto succ : successors(list[i])) {
+      if (visited.emplace(succ).second) {
+        list.emplace_back(succ);
+      }
+    }
+  }
+}
+
+void InstructionApplier::getExits(BasicBlock *begin,
+                                  std::vector<Instruction *> &list) {
+  std::vector<BasicBlock *> region;
+
+  getRegion(begin, region);
+  list.clear();
+
+  for (auto block : region) {
+    auto term = block->getTerminator();
+
+    if (isa<ReturnInst>(term) || isa<ResumeInst>(term)) {
+      list.emplace_back(term);
+    }
+  }
+}
+
+bool InstructionApplier::hasEarlyExit(BasicBlock *begin) {
+  std::vector<BasicBlock *> region;
+
+  getRegion(begin, region);
+
+  for (auto block : region) {
+    for (auto &inst : *block) {
+      auto call = dyn_cast<CallBase>(&inst);
+
+      if (!call || call->isInlineAsm()) {
+        continue;
+      }
+
+      // exit(), longjmp() or call which unwinds past this function
+      if (call->doesNotReturn() ||
+          (!isa<InvokeInst>(call) && !call->doesNotThrow())) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+BasicBlock *InstructionApplier::cloneBody(Function &func, Instruction *next) {
+  // Blocks with address taken cannot be duplicated
+  for (auto &block : func) {
+    if (block.hasAddressTaken()) {
+      return nullptr;
+    }
+  }
+
+  // Instructions before marker (allocas, arguments) are shared
+  auto head = next->getParent();
+  auto body = head->splitBasicBlock(next, "inststat.body");
+
+  ValueToValueMapTy vmap;
+  std::vector<BasicBlock *> blocks;
+  std::vector<BasicBlock *> clones;
+
+  for (auto &block : func) {
+    if (&block != head) {
+      blocks.emplace_back(&block);
+    }
+  }
+
+  for (auto block : blocks) {
+    auto clone = CloneBasicBlock(block, vmap, ".plain", &func);
+
+    vmap[block] = clone;
+    clones.emplace_back(clone);
+  }
+
+  for (auto clone : clones) {
+    for (auto &inst : *clone) {
+      RemapInstruction(&inst, vmap,
+                       RF_NoModuleLevelChanges | RF_IgnoreMissingLocals);
+    }
+  }
+
+  return cast<BasicBlock>(vmap[body]);
+}
+
+void InstructionApplier::makeDispatch(Function &func, Instruction *next,
+                                      BasicBlock *plain) {
+  // %enabled = load i8, i8* @__inststat_enabled
+  // br %enabled != 0, %sample, %body.plain
+  // sample:
+  //   %count = load i32, i32* @countdown
+  //   %dec = sub i32 %count, 1
+  //   store i32 %dec, i32* @countdown
+  //   br %dec <= 0, %body, %body.plain
+  // body:
+  //   store i32 rate, i32* @countdown
+
+  auto &module = *func.getParent();
+  auto body = next->getParent();
+  auto head = body->getSinglePredecessor();
+  auto term = head->getTerminator();
+  IRBuilder<> builder(term);
+
+  Value *cond = builder.getTrue();
+  MDNode *weights = nullptr;
+
+  if (runtimeSwitch) {
+    auto flag = module.getGlobalVariable(RT_SWITCH_FLAG);
+
+    if (flag == nullptr) {
+      flag = new GlobalVariable(module, builder.getInt8Ty(), false,
+                                GlobalValue::ExternalLinkage, nullptr,
+                                RT_SWITCH_FLAG);
+    }
+
+    cond = builder.CreateICmpNE(builder.CreateLoad(builder.getInt8Ty(), flag),
+                                builder.getInt8(0), "enabled");
+  }
+
+  if (sampleRate > 1) {
+    // Per-thread countdown in shard mode, so threads do not share its line
+    auto countdown = new GlobalVariable(
+        module, builder.getInt32Ty(), false, GlobalValue::InternalLinkage,
+        builder.getInt32(sampleRate), "inststat.sample." + func.getName(),
+        nullptr,
+        shard ? GlobalValue::GeneralDynamicTLSModel
+              : GlobalValue::NotThreadLocal);
+
+    // Countdown only decreases while instrumentation is enabled - plain path
+    // does not touch it
+    if (runtimeSwitch) {
+      auto sample =
+          BasicBlock::Create(func.getContext(), "sample", &func, body);
+
+      builder.CreateCondBr(cond, sample, plain);
+      term->eraseFromParent();
+
+      term = nullptr;
+      builder.SetInsertPoint(sample);
+    }
+
+    auto value =
+        builder.CreateSub(builder.CreateLoad(builder.getInt32Ty(), countdown),
+                          builder.getInt32(1));
+
+    builder.CreateStore(value, countdown);
+
+    cond = builder.CreateICmpSLT(value, builder.getInt32(1), "sampled");
+    weights =
+        MDBuilder(module.getContext()).createBranchWeights(1, sampleRate - 1);
+
+    // Reload countdown
+    IRBuilder<> reloadBuilder(next);
+
+    reloadBuilder.CreateStore(builder.getInt32(sampleRate), countdown);
+  }
+
+  builder.CreateCondBr(cond, body, plain, weights);
+
+  if (term) {
+    term->eraseFromParent();
+  }
+}
+
+void InstructionApplier::makeSampleRecord(Function &func, Instruction *next) {
+  // Cycles of sampled invocation are reported to runtime, for error estimate
+  auto &module = *func.getParent();
+  IRBuilder<> builder(next);
+
+  auto id = new GlobalVariable(module, builder.getInt32Ty(), false,
+                               GlobalValue::InternalLinkage,
+                               builder.getInt32(0),
+                               "inststat.sample.id." + func.getName());
+
+  IRBuilder<> ctorBuilder(getCtor(module));
+  auto reg = module.getOrInsertFunction(
+      RT_SAMPLE_REGISTER, builder.getInt32Ty(), builder.getInt8PtrTy(),
+      builder.getInt32Ty());
+
+  ctorBuilder.CreateStore(
+      ctorBuilder.CreateCall(
+          reg, {ctorBuilder.CreateGlobalStringPtr(func.getName()),
+                ctorBuilder.getInt32(sampleRate)}),
+      id);
+
+  // Cycles at function entry
+  auto start = builder.CreateLoad(builder.getInt64Ty(),
+                                  pointers[Counter::Cycles], "sample_start");
+
+  auto record = module.getOrInsertFunction(
+      RT_SAMPLE_RECORD, builder.getVoidTy(), builder.getInt32Ty(),
+      builder.getInt64Ty());
+  std::vector<Instruction *> exits;
+
+  getExits(next->getParent(), exits);
+
+  for (auto exit : exits) {
+    IRBuilder<> exitBuilder(exit);
+
+    auto end = exitBuilder.CreateLoad(exitBuilder.getInt64Ty(),
+                                      pointers[Counter::Cycles]);
+
+    exitBuilder.CreateCall(
+        record, {exitBuilder.CreateLoad(exitBuilder.getInt32Ty(), id),
+                 exitBuilder.CreateSub(end, start)});
+  }
+}
+
+void InstructionApplier::makeTrace(Function &func, Instruction *next) {
+  // Each invocation records (id, host time at entry, cycles consumed)
+  auto &module = *func.getParent();
+  IRBuilder<> builder(next);
+
+  auto id = new GlobalVariable(module, builder.getInt32Ty(), false,
+                               GlobalValue::InternalLinkage,
+                               builder.getInt32(0),
+                               "inststat.trace.id." + func.getName());
+
+  IRBuilder<> ctorBuilder(getCtor(module));
+  auto reg = module.getOrInsertFunction(
+      RT_TRACE_REGISTER, builder.getInt32Ty(), builder.getInt8PtrTy());
+
+  ctorBuilder.CreateStore(
+      ctorBuilder.CreateCall(
+          reg, {ctorBuilder.CreateGlobalStringPtr(func.getName())}),
+      id);
+
+  // Host time and cycles at function entry
+  auto clock = module.getOrInsertFunction(RT_TRACE_CLOCK, builder.getInt64Ty());
+  auto time = builder.CreateCall(clock, {}, "trace_time");
+  auto start = builder.CreateLoad(builder.getInt64Ty(),
+                                  pointers[Counter::Cycles], "trace_start");
+
+  auto record = module.getOrInsertFunction(
+      RT_TRACE_RECORD, builder.getVoidTy(), builder.getInt32Ty(),
+      builder.getInt64Ty(), builder.getInt64Ty());
+  std::vector<Instruction *> exits;
+
+  getExits(next->getParent(), exits);
+
+  for (auto exit : exits) {
+    IRBuilder<> exitBuilder(exit);
+
+    auto end = exitBuilder.CreateLoad(exitBuilder.getInt64Ty(),
+                                      pointers[Counter::Cycles]);
+
+    exitBuilder.CreateCall(
+        record, {exitBuilder.CreateLoad(exitBuilder.getInt32Ty(), id), time,
+                 exitBuilder.CreateSub(end, start)});
+  }
+}
+
+void InstructionApplier::makeHistogram(Function &func, Instruction *next) {
+  // @buckets = internal global [RT_HISTOGRAM_BUCKETS x i64] zeroinitializer
+  // Each exit:
+  //   %v = end - start
+  //   %shift = (63 - ctlz(%v | (1 << SUB_BITS))) - SUB_BITS
+  //   atomicrmw add @buckets[(%shift << SUB_BITS) + (%v >> %shift)], 1
+  // Constructor: __inststat_histogram_register(name, buckets)
+  auto &module = *func.getParent();
+  IRBuilder<> builder(next);
+
+  auto i64 = builder.getInt64Ty();
+  auto bucketType = ArrayType::get(i64, RT_HISTOGRAM_BUCKETS);
+  auto buckets = new GlobalVariable(
+      module, bucketType, false, GlobalValue::InternalLinkage,
+      ConstantAggregateZero::get(bucketType),
+      "inststat.histogram." + func.getName());
+
+  IRBuilder<> ctorBuilder(getCtor(module));
+  auto reg = module.getOrInsertFunction(RT_HISTOGRAM_REGISTER,
+                                        builder.getVoidTy(),
+                                        builder.getInt8PtrTy(),
+                                        i64->getPointerTo());
+
+  ctorBuilder.CreateCall(
+      reg, {ctorBuilder.CreateGlobalStringPtr(func.getName()),
+            ctorBuilder.CreateConstInBoundsGEP2_32(bucketType, buckets, 0, 0)});
+
+  // Cycles at function entry
+  auto start = builder.CreateLoad(i64, pointers[Counter::Cycles],
+                                  "histogram_start");
+
+  std::vector<Instruction *> exits;
+
+  getExits(next->getParent(), exits);
+
+  for (auto exit : exits) {
+    IRBuilder<> exitBuilder(exit);
+
+    auto end = exitBuilder.CreateLoad(i64, pointers[Counter::Cycles]);
+    auto value = exitBuilder.CreateSub(end, start);
+    auto zeros = exitBuilder.CreateBinaryIntrinsic(
+        Intrinsic::ctlz,
+        exitBuilder.CreateOr(value, 1ull << RT_HISTOGRAM_SUB_BITS),
+        exitBuilder.getTrue());
+    auto shift = exitBuilder.CreateSub(
+        exitBuilder.getInt64(63 - RT_HISTOGRAM_SUB_BITS), zeros);
+    auto index = exitBuilder.CreateAdd(
+        exitBuilder.CreateShl(shift, RT_HISTOGRAM_SUB_BITS),
+        exitBuilder.CreateLShr(value, shift));
+
+    // Histogram is shared by all threads
+    auto bucket = exitBuilder.CreateInBoundsGEP(
+        bucketType, buckets, {exitBuilder.getInt64(0), index});
+
+#if LLVM_VERSION_MAJOR >= 13
+    exitBuilder.CreateAtomicRMW(AtomicRMWInst::Add, bucket,
+                                exitBuilder.getInt64(1), MaybeAlign(8),
+                                AtomicOrdering::Monotonic);
+#else
+    exitBuilder.CreateAtomicRMW(AtomicRMWInst::Add, bucket,
+                                exitBuilder.getInt64(1),
+                                AtomicOrdering::Monotonic);
+#endif
+  }
+}
+
+void InstructionApplier::makeBranchModel(Function &func, Instruction *next) {
+  // @sites = internal global [N x { i64, i64, i64 }] zeroinitializer
+  // Conditional branch: __inststat_branch(&sites[i], zext %cond, %cycles)
+  // Switch, indirectbr, indirect call:
+  //   __inststat_indirect(&sites[i], target, %cycles)
+  // Constructor: __inststat_branch_register(name, sites, branches, indirects)
+  auto &module = *func.getParent();
+  std::vector<BasicBlock *> region;
+  std::vector<Instruction *> branches;
+  std::vector<Instruction *> indirects;
+
+  getRegion(next->getParent(), region);
+
+  for (auto block : region) {
+    for (auto &inst : *block) {
+      if (auto br = dyn_cast<BranchInst>(&inst)) {
+        if (br->isConditional()) {
+          branches.emplace_back(br);
+        }
+      }
+      else if (isa<SwitchInst>(inst) || isa<IndirectBrInst>(inst)) {
+        indirects.emplace_back(&inst);
+      }
+      else if (auto call = dyn_cast<CallBase>(&inst)) {
+        if (call->isIndirectCall()) {
+          indirects.emplace_back(call);
+        }
+      }
+    }
+  }
+
+  if (branches.size() + indirects.size() == 0) {
+    return;
+  }
+
+  IRBuilder<> ctorBuilder(getCtor(module));
+
+  auto i64 = ctorBuilder.getInt64Ty();
+  auto siteType = StructType::get(i64, i64, i64);
+  auto sitePtrType = siteType->getPointerTo();
+  auto tableType = ArrayType::get(siteType, branches.size() + indirects.size());
+  auto sites = new GlobalVariable(module, tableType, false,
+                                  GlobalValue::InternalLinkage,
+                                  ConstantAggregateZero::get(tableType),
+                                  "inststat.branch." + func.getName());
+
+  auto reg = module.getOrInsertFunction(
+      RT_BRANCH_REGISTER, ctorBuilder.getVoidTy(), ctorBuilder.getInt8PtrTy(),
+      sitePtrType, ctorBuilder.getInt32Ty(), ctorBuilder.getInt32Ty());
+
+  ctorBuilder.CreateCall(
+      reg, {ctorBuilder.CreateGlobalStringPtr(func.getName()),
+            ctorBuilder.CreateConstInBoundsGEP2_32(tableType, sites, 0, 0),
+            ctorBuilder.getInt32(branches.size()),
+            ctorBuilder.getInt32(indirects.size())});
+
+  auto record = module.getOrInsertFunction(
+      RT_BRANCH_RECORD, ctorBuilder.getVoidTy(), sitePtrType,
+      ctorBuilder.getInt8Ty(), i64->getPointerTo());
+  auto recordIndirect = module.getOrInsertFunction(
+      RT_INDIRECT_RECORD, ctorBuilder.getVoidTy(), sitePtrType, i64,
+      i64->getPointerTo());
+  uint32_t idx = 0;
+
+  for (auto inst : branches) {
+    IRBuilder<> builder(inst);
+
+    builder.CreateCall(
+        record, {builder.CreateConstInBoundsGEP2_32(tableType, sites, 0, idx++),
+                 builder.CreateZExt(cast<BranchInst>(inst)->getCondition(),
+                                    builder.getInt8Ty()),
+                 pointers[Counter::Cycles]});
+  }
+
+  for (auto inst : indirects) {
+    IRBuilder<> builder(inst);
+    Value *target;
+
+    // Switch may be lowered to jump table - case value selects target
+    if (auto sw = dyn_cast<SwitchInst>(inst)) {
+      target = builder.CreateZExtOrTrunc(sw->getCondition(), i64);
+    }
+    else if (auto ibr = dyn_cast<IndirectBrInst>(inst)) {
+      target = builder.CreatePtrToInt(ibr->getAddress(), i64);
+    }
+    else {
+      target = builder.CreatePtrToInt(
+          cast<CallBase>(inst)->getCalledOperand(), i64);
+    }
+
+    builder.CreateCall(
+        recordIndirect,
+        {builder.CreateConstInBoundsGEP2_32(tableType, sites, 0, idx++), target,
+         pointers[Counter::Cycles]});
+  }
+}
+
+void InstructionApplier::makeMemoryCost(Function &func, Instruction *next,
+                                        bool table) {
+  // Each call: cycles += (length + B - 1) / B
+  // B = bytes per cycle of CPU model, or table[cpu][set] with cost table:
+  // @inststat.memory = private constant [M x [2 x i64]] (copy, set)
+
+  auto &module = *func.getParent();
+  auto i64 = Type::getInt64Ty(func.getContext());
+  std::vector<BasicBlock *> region;
+  std::vector<std::tuple<Instruction *, Value *, bool>> calls;
+
+  getRegion(next->getParent(), region);
+
+  for (auto block : region) {
+    for (auto &inst : *block) {
+      if (auto mem = dyn_cast<MemIntrinsic>(&inst)) {
+        // Small copy is expanded to loads and stores
+        auto length = dyn_cast<ConstantInt>(mem->getLength());
+
+        if (length && length->getZExtValue() <= memoryInline) {
+          continue;
+        }
+
+        calls.emplace_back(mem, mem->getLength(), isa<MemSetInst>(mem));
+
+        continue;
+      }
+
+      auto call = dyn_cast<CallBase>(&inst);
+      auto callee = call ? call->getCalledFunction() : nullptr;
+
+      if (callee == nullptr) {
+        continue;
+      }
+
+      for (auto &routine : routines) {
+        if (callee->getName() == routine.name &&
+            routine.length < call->arg_size()) {
+          calls.emplace_back(call, call->getArgOperand(routine.length),
+                             routine.set);
+
+          break;
+        }
+      }
+    }
+  }
+
+  if (calls.size() == 0 || pointers[Counter::Cycles] == nullptr) {
+    return;
+  }
+
+  // Same default as generator when statistic file has no memory: line
+  static const MemoryStat fallback{8, 8};
+
+  auto getStat = [this](uint32_t m) -> const MemoryStat & {
+    if (memorylist.size() == 0) {
+      return fallback;
+    }
+
+    return memorylist[std::min<size_t>(m, memorylist.size() - 1)];
+  };
+
+  if (table && memoryTable == nullptr) {
+    auto rowType = ArrayType::get(i64, 2);
+    auto tableType = ArrayType::get(rowType, models.size());
+    std::vector<Constant *> rows;
+
+    for (uint32_t m = 0; m < models.size(); m++) {
+      auto &stat = getStat(m);
+      uint64_t values[2] = {std::max<uint64_t>(stat.copy, 1),
+                            std::max<uint64_t>(stat.set, 1)};
+
+      rows.emplace_back(ConstantDataArray::get(func.getContext(), values));
+    }
+
+    memoryTable = new GlobalVariable(module, tableType, true,
+                                     GlobalValue::PrivateLinkage,
+                                     ConstantArray::get(tableType, rows),
+                                     "inststat.memory");
+  }
+
+  for (auto &call : calls) {
+    auto inst = std::get<0>(call);
+    bool set = std::get<2>(call);
+    IRBuilder<> builder(inst);
+    Value *bandwidth;
+
+    if (table) {
+      auto index =
+          builder.CreateLoad(builder.getInt32Ty(), getCPUModel(module));
+
+      bandwidth = builder.CreateLoad(
+          i64, builder.CreateInBoundsGEP(
+                   memoryTable->getValueType(), memoryTable,
+                   {builder.getInt32(0), index, builder.getInt32(set)}));
+    }
+    else {
+      auto &stat = getStat(0);
+
+      bandwidth =
+          builder.getInt64(std::max<uint64_t>(set ? stat.set : stat.copy, 1));
+    }
+
+    auto length = builder.CreateZExtOrTrunc(std::get<1>(call), i64);
+    auto cycles = builder.CreateUDiv(
+        builder.CreateAdd(length,
+                          builder.CreateSub(bandwidth, builder.getInt64(1))),
+        bandwidth);
+
+    makeAdd(inst, pointers[Counter::Cycles], cycles);
+  }
+
+  // Log result if possible
+  if (resultfile.is_open()) {
+    resultfile << " MemoryCost: " << calls.size() << " calls" << std::endl;
+  }
+}
+
+void InstructionApplier::getMemoryAccesses(BasicBlock *begin,
+                                           std::vector<Instruction *> &accesses,
+                                           std::vector<Instruction *> &calls) {
+  // Must be collected before counter updates are inserted
+  std::vector<BasicBlock *> region;
+
+  getRegion(begin, region);
+
+  for (auto block : region) {
+    for (auto &inst : *block) {
+      if (isa<LoadInst>(inst) || isa<StoreInst>(inst) ||
+          isa<AtomicRMWInst>(inst) || isa<AtomicCmpXchgInst>(inst)) {
+        auto ptr = getLoadStorePointerOperand(&inst);
+
+        if (ptr == nullptr) {
+          ptr = isa<AtomicRMWInst>(inst)
+                    ? cast<AtomicRMWInst>(inst).getPointerOperand()
+                    : cast<AtomicCmpXchgInst>(inst).getPointerOperand();
+        }
+
+        // Skip instrumentation variables (sampling countdown)
+        auto global = dyn_cast<GlobalVariable>(ptr->stripPointerCasts());
+
+        if (global && global->getName().startswith("inststat.")) {
+          continue;
+        }
+
+        accesses.emplace_back(&inst);
+      }
+      else if (auto call = dyn_cast<CallBase>(&inst)) {
+        if (!isa<IntrinsicInst>(call) && !call->isInlineAsm()) {
+          calls.emplace_back(call);
+        }
+      }
+    }
+  }
+}
+
+void InstructionApplier::makeCacheModel(Function &func, Instruction *next,
+                                        std::vector<Instruction *> &accesses,
+                                        std::vector<Instruction *> &calls) {
+  // Each access:
+  //   %count = load i32, i32* @__inststat_cache_count
+  //   store i64 (addr | size << 56 | store << 63), @__inststat_cache_buffer[%count]
+  //   store i32 (%count + 1), i32* @__inststat_cache_count
+  // Every RT_CACHE_BATCH accesses and end of block:
+  //   if (%count >= SIZE - BATCH) __inststat_cache_flush(%cycles)
+  // Before calls and exits: __inststat_cache_flush(%cycles)
+  auto &module = *func.getParent();
+  auto &layout = module.getDataLayout();
+  IRBuilder<> builder(next);
+
+  auto i64 = builder.getInt64Ty();
+  auto i32 = builder.getInt32Ty();
+  auto bufferType = ArrayType::get(i64, RT_CACHE_BUFFER_SIZE);
+  auto buffer = module.getGlobalVariable(RT_CACHE_BUFFER);
+  auto count = module.getGlobalVariable(RT_CACHE_COUNT);
+
+  if (buffer == nullptr) {
+    buffer = new GlobalVariable(module, bufferType, false,
+                                GlobalValue::ExternalLinkage, nullptr,
+                                RT_CACHE_BUFFER, nullptr,
+                                GlobalValue::InitialExecTLSModel);
+  }
+
+  if (count == nullptr) {
+    count = new GlobalVariable(module, i32, false,
+                               GlobalValue::ExternalLinkage, nullptr,
+                               RT_CACHE_COUNT, nullptr,
+                               GlobalValue::InitialExecTLSModel);
+  }
+
+  auto flush = module.getOrInsertFunction(RT_CACHE_FLUSH, builder.getVoidTy(),
+                                          i64->getPointerTo());
+  auto weights = MDBuilder(module.getContext()).createBranchWeights(1, 1 << 10);
+
+  auto makeCheck = [&](Instruction *before) {
+    IRBuilder<> checkBuilder(before);
+
+    auto full = checkBuilder.CreateICmpUGE(
+        checkBuilder.CreateLoad(i32, count),
+        checkBuilder.getInt32(RT_CACHE_BUFFER_SIZE - RT_CACHE_BATCH),
+        "cache_full");
+    auto then = SplitBlockAndInsertIfThen(full, before, false, weights);
+
+    IRBuilder<> flushBuilder(then);
+
+    flushBuilder.CreateCall(flush, {pointers[Counter::Cycles]});
+  };
+
+  // Group accesses by block, in order
+  std::vector<std::vector<Instruction *>> groups;
+  std::unordered_map<BasicBlock *, uint32_t> groupid;
+
+  for (auto inst : accesses) {
+    auto iter = groupid.emplace(inst->getParent(), groups.size());
+
+    if (iter.second) {
+      groups.emplace_back();
+    }
+
+    groups[iter.first->second].emplace_back(inst);
+  }
+
+  for (auto &group : groups) {
+    for (uint32_t i = 0; i < group.size(); i++) {
+      auto inst = group[i];
+      IRBuilder<> accessBuilder(inst);
+      Value *ptr = getLoadStorePointerOperand(inst);
+      Type *type = nullptr;
+      bool store = !isa<LoadInst>(inst);
+
+      if (auto load = dyn_cast<LoadInst>(inst)) {
+        type = load->getType();
+      }
+      else if (auto st = dyn_cast<StoreInst>(inst)) {
+        type = st->getValueOperand()->getType();
+      }
+      else if (auto rmw = dyn_cast<AtomicRMWInst>(inst)) {
+        ptr = rmw->getPointerOperand();
+        type = rmw->getValOperand()->getType();
+      }
+      else {
+        auto cmpxchg = cast<AtomicCmpXchgInst>(inst);
+
+        ptr = cmpxchg->getPointerOperand();
+        type = cmpxchg->getNewValOperand()->getType();
+      }
+
+      uint64_t size =
+          std::min<uint64_t>(layout.getTypeStoreSize(type).getFixedSize(), 127);
+      uint64_t tag = (size << 56) | ((store ? 1ull : 0ull) << 63);
+
+      auto entry = accessBuilder.CreateOr(
+          accessBuilder.CreateAnd(accessBuilder.CreatePtrToInt(ptr, i64),
+                                  (1ull << 56) - 1),
+          tag);
+      auto index = accessBuilder.CreateLoad(i32, count);
+      auto slot = accessBuilder.CreateInBoundsGEP(
+          bufferType, buffer,
+          {accessBuilder.getInt64(0), accessBuilder.CreateZExt(index, i64)});
+
+      accessBuilder.CreateStore(entry, slot);
+      accessBuilder.CreateStore(
+          accessBuilder.CreateAdd(index, accessBuilder.getInt32(1)), count);
+
+      // Long block - check in the middle
+      if ((i + 1) % RT_CACHE_BATCH == 0 && i + 1 < group.size()) {
+        makeCheck(inst->getNextNode());
+      }
+    }
+
+    makeCheck(group.back()->getParent()->getTerminator());
+  }
+
+  // Stall cycles belong to this function - callee may be marked function
+  for (auto call : calls) {
+    IRBuilder<> callBuilder(call);
+
+    callBuilder.CreateCall(flush, {pointers[Counter::Cycles]});
+  }
+
+  std::vector<Instruction *> exits;
+
+  getExits(next->getParent(), exits);
+
+  for (auto exit : exits) {
+    IRBuilder<> exitBuilder(exit);
+
+    exitBuilder.CreateCall(flush, {pointers[Counter::Cycles]});
+  }
+}
+
+bool InstructionApplier::applyEdgeProfile(
+    Function &func, Instruction *next,
+    std::unordered_map<BasicBlock *, LineStat> &blockstats) {
+  // Node 0 ~ N - 1: basic blocks, Node N: virtual exit node
+  std::unordered_map<BasicBlock *, uint32_t> nodeid;
+  std::vector<BasicBlock *> nodelist;
+  std::vector<Instruction *> exits;
+
+  // Only blocks reachable from pointers are instrumented
+  getRegion(next->getParent(), nodelist);
+
+  for (auto block : nodelist) {
+    nodeid.emplace(block, nodeid.size());
+  }
+
+  uint32_t virt = nodelist.size();
+  SpanningTree tree(virt + 1);
+
+  auto &bfi = getAnalysis<BlockFrequencyInfoWrapperPass>().getBFI();
+  auto &bpi = getAnalysis<BranchProbabilityInfoWrapperPass>().getBPI();
+
+  // Edge priority
+  enum : uint8_t {
+    Fixed,    // Edge we cannot instrument - must be tree edge
+    Normal,   // Normal CFG edge
+    Exit,     // Block -> virtual, known when function returns
+    Invoke,   // Virtual -> entry, always one
+  };
+
+  // Edge index -> where counter should be placed
+  std::vector<Instruction *> placement;
+  std::vector<std::pair<BasicBlock *, BasicBlock *>> edgelist;
+
+  for (auto block : nodelist) {
+    auto term = block->getTerminator();
+    uint32_t src = nodeid[block];
+
+    if (term->getNumSuccessors() == 0) {
+      // Function returns here
+      if (isa<ReturnInst>(term) || isa<ResumeInst>(term)) {
+        exits.emplace_back(term);
+      }
+
+      tree.addEdge(src, virt, 0, Exit);
+      edgelist.emplace_back(block, nullptr);
+
+      continue;
+    }
+
+    for (uint32_t i = 0; i < term->getNumSuccessors(); i++) {
+      auto succ = term->getSuccessor(i);
+      bool duplicated = false;
+
+      // Count u -> v once, although terminator (switch) has multiple edges
+      for (uint32_t j = 0; j < i; j++) {
+        if (term->getSuccessor(j) == succ) {
+          duplicated = true;
+
+          break;
+        }
+      }
 
-void InstructionApplier::makePointers(Instruction *next, Value *fstat) {
-  // %ptr = getelementptr inbounds %"class.SimpleSSD::CPU::Function",
-  // %"class.SimpleSSD::CPU::Function"* %fstat, i32 0, i32 %idx
+      if (duplicated) {
+        continue;
+      }
 
-  // Create builder
+      auto freq = bpi.getEdgeProbability(block, succ)
+                      .scale(bfi.getBlockFreq(block).getFrequency());
+      auto priority = Normal;
+
+      // We cannot split edges from indirectbr, callbr or to EH pad
+      if (succ->isEHPad() || isa<IndirectBrInst>(term) ||
+          isa<CallBrInst>(term)) {
+        priority = Fixed;
+      }
+
+      tree.addEdge(src, nodeid[succ], freq, priority);
+      edgelist.emplace_back(block, succ);
+    }
+  }
+
+  // Infinite loop - function never returns
+  if (exits.size() == 0) {
+    return false;
+  }
+
+  tree.addEdge(virt, 0, 0, Invoke);
+  edgelist.emplace_back(nullptr, nodelist.front());
+
+  if (!tree.build(virt)) {
+    return false;
+  }
+
+  auto &edges = tree.getEdges();
+  auto &chords = tree.getChords();
+
+  // Total statistic contributed by each chord
+  std::vector<LineStat> weights(chords.size());
+
+  auto nonzero = [](LineStat &stat) -> bool {
+    for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+      if (stat[i] != 0) {
+        return true;
+      }
+    }
+
+    return false;
+  };
+
+  for (uint32_t e = 0; e < edges.size(); e++) {
+    auto block = edgelist[e].first;
+
+    if (block == nullptr) {
+      continue;
+    }
+
+    auto stat = blockstats.find(block);
+
+    if (stat == blockstats.end()) {
+      continue;
+    }
+
+    // Block count = sum of outgoing edge counts
+    auto &coeff = tree.getCoefficient(e);
+
+    for (uint32_t c = 0; c < chords.size(); c++) {
+      if (coeff[c] == 0) {
+        continue;
+      }
+
+      // Wraps around when coefficient is negative, but sum is always valid
+      for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+        weights[c][i] += stat->second[i] * (uint64_t)coeff[c];
+      }
+    }
+  }
+
+  // Find where to place counter of each chord
+  placement.resize(chords.size(), nullptr);
+
+  for (uint32_t c = 0; c < chords.size(); c++) {
+    auto &edge = edgelist[chords[c]];
+    auto priority = edges[chords[c]].priority;
+
+    if (priority == Exit || priority == Invoke) {
+      // Known when function returns
+      continue;
+    }
+    else if (!nonzero(weights[c])) {
+      // This chord does not change any statistic
+      continue;
+    }
+    else if (priority == Fixed) {
+      return false;
+    }
+
+    auto src = edge.first;
+    auto dst = edge.second;
+    auto term = src->getTerminator();
+    bool single = true;
+
+    for (uint32_t i = 0; i < term->getNumSuccessors(); i++) {
+      if (term->getSuccessor(i) != dst) {
+        single = false;
+
+        break;
+      }
+    }
+
+    if (single) {
+      // src -> dst is only path of src
+      placement[c] = term;
+    }
+    else if (dst->getUniquePredecessor() == src &&
+             dst->getFirstInsertionPt() != dst->end()) {
+      // src -> dst is only path to dst
+      placement[c] = &*dst->getFirstInsertionPt();
+    }
+    else {
+      // Critical edge
+      uint32_t idx = 0;
+
+      for (; idx < term->getNumSuccessors(); idx++) {
+        if (term->getSuccessor(idx) == dst) {
+          break;
+        }
+      }
+
+      auto split = SplitCriticalEdge(
+          term, idx, CriticalEdgeSplittingOptions().setMergeIdenticalEdges());
+
+      if (split == nullptr) {
+        return false;
+      }
+
+      placement[c] = split->getTerminator();
+    }
+  }
+
+  // Make counters
   IRBuilder<> builder(next);
+  std::vector<AllocaInst *> counters(chords.size(), nullptr);
+  auto &entry = func.getEntryBlock();
+
+  for (uint32_t c = 0; c < chords.size(); c++) {
+    if (placement[c] == nullptr) {
+      continue;
+    }
+
+    // Allocate at beginning of function, so SROA can promote it
+    IRBuilder<> allocaBuilder(&*entry.getFirstInsertionPt());
+
+    counters[c] =
+        allocaBuilder.CreateAlloca(builder.getInt64Ty(), nullptr, "edge_count");
+
+    builder.CreateStore(builder.getInt64(0), counters[c]);
+
+    // Increase counter
+    IRBuilder<> edgeBuilder(placement[c]);
+
+    auto load = edgeBuilder.CreateLoad(builder.getInt64Ty(), counters[c]);
+    auto add = edgeBuilder.CreateAdd(load, edgeBuilder.getInt64(1));
+
+    edgeBuilder.CreateStore(add, counters[c]);
+
+    // Chord counter is an update, although it may live in register
+    makeUpdateCount(placement[c]);
+  }
+
+  // Reconstruct statistics at each exit
+  for (auto exit : exits) {
+    IRBuilder<> exitBuilder(exit);
+    LineStat known;
+    std::vector<Value *> values(chords.size(), nullptr);
+
+    for (uint32_t c = 0; c < chords.size(); c++) {
+      auto &edge = edgelist[chords[c]];
+
+      if (counters[c]) {
+        values[c] = exitBuilder.CreateLoad(builder.getInt64Ty(), counters[c]);
+      }
+      else if (edge.first == nullptr || edge.first == exit->getParent()) {
+        // Virtual -> entry and current exit -> virtual are executed once
+        known += weights[c];
+      }
+    }
+
+    for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+      Value *sum = exitBuilder.getInt64(known[i]);
+
+      for (uint32_t c = 0; c < chords.size(); c++) {
+        if (values[c] && weights[c][i] == 1) {
+          sum = exitBuilder.CreateAdd(sum, values[c]);
+        }
+        else if (values[c] && weights[c][i] != 0) {
+          sum = exitBuilder.CreateAdd(
+              sum, exitBuilder.CreateMul(values[c],
+                                         exitBuilder.getInt64(weights[c][i])));
+        }
+      }
+
+      auto constant = dyn_cast<ConstantInt>(sum);
+
+      if ((constant && constant->isZero()) || pointers[i] == nullptr) {
+        continue;
+      }
 
-  // %idx
-  auto idx0 = builder.getInt32(0);
-  auto idx1 = builder.getInt32(1);
-  auto idx2 = builder.getInt32(2);
-  auto idx3 = builder.getInt32(3);
-  auto idx4 = builder.getInt32(4);
-  auto idx5 = builder.getInt32(5);
-  auto idx6 = builder.getInt32(6);
-
-  // IdxList
-  Value *idxList0[2] = {idx0, idx0};
-  Value *idxList1[2] = {idx0, idx1};
-  Value *idxList2[2] = {idx0, idx2};
-  Value *idxList3[2] = {idx0, idx3};
-  Value *idxList4[2] = {idx0, idx4};
-  Value *idxList5[2] = {idx0, idx5};
-  Value *idxList6[2] = {idx0, idx6};
-
-  // Add instructions
-  pointers.branch = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList0, 2), "fstat_branch");
-  pointers.load = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList1, 2), "fstat_load");
-  pointers.store = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList2, 2), "fstat_store");
-  pointers.arithmetic = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList3, 2), "fstat_arithmetic");
-  pointers.floating = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList4, 2), "fstat_floating");
-  pointers.other = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList5, 2), "fstat_other");
-  pointers.cycles = builder.CreateInBoundsGEP(
-      fstat, ArrayRef<Value *>(idxList6, 2), "fstat_cycles");
+      makeAdd(exit, pointers[i], sum);
+    }
+  }
+
+  // Log result if possible
+  if (resultfile.is_open()) {
+    uint32_t count = 0;
+
+    for (auto counter : counters) {
+      if (counter) {
+        count++;
+      }
+    }
+
+    resultfile << " EdgeProfile: " << nodelist.size() << " blocks, "
+               << edges.size() << " edges, " << count << " counters"
+               << std::endl;
+  }
+
+  return true;
 }
 
-void InstructionApplier::makeAdd(llvm::Instruction *next, Value *target,
-                                 uint64_t value) {
-  // %reg = load i64, i64* %target, align 8
-  // %add = add i64 %reg, %value
-  // store i64 %add, i64* %target, align 8
+void InstructionApplier::saveCoverage(Module &module) {
+  // Assembly cycles of function, or lines of statistic file if generator did
+  // not match assembly function (older statistic file)
+  auto getTotal = [](Coverage &c) -> uint64_t {
+    return c.asmCycles > 0 ? c.asmCycles : c.statCycles;
+  };
 
-  // Create builder
-  IRBuilder<> builder(next);
+  Coverage sum = Coverage();
+  uint64_t total = 0;
+  uint32_t missing = 0;
+
+  for (auto &c : coverages) {
+    total += getTotal(c);
+    sum.asmCycles += c.asmCycles;
+    sum.statCycles += c.statCycles;
+    sum.appliedCycles += c.appliedCycles;
+    sum.calleeCycles += c.calleeCycles;
+    sum.droppedLines += c.droppedLines;
+    sum.droppedCycles += c.droppedCycles;
+    sum.unmatchedLines += c.unmatchedLines;
+    sum.unmatchedCycles += c.unmatchedCycles;
+    sum.blocks += c.blocks;
+    sum.lineBlocks += c.lineBlocks;
+    sum.rangeBlocks += c.rangeBlocks;
+    sum.unmatchedBlocks += c.unmatchedBlocks;
+
+    if (strcmp(c.match, "none") == 0) {
+      missing++;
+    }
+  }
 
-  // Load
-  auto load = builder.CreateLoad(target);
-#if LLVM_VERSION_MAJOR >= 10
-  load->setAlignment(Align(8));
-#else
-  load->setAlignment(8);
-#endif
+  auto percent = [](uint64_t applied, uint64_t total) {
+    return total > 0 ? applied * 100.0 / total : 100.0;
+  };
 
-  // Add
-  auto add = builder.CreateAdd(builder.getInt64(value), load);
+  if (coverageReport) {
+    std::string filename(inputFile);
 
-  // Store
-  auto store = builder.CreateStore(add, target);
-#if LLVM_VERSION_MAJOR >= 10
-  store->setAlignment(Align(8));
-#else
-  store->setAlignment(8);
-#endif
+    filename += module.getName().data();
+    filename += IA_FILE_POSTFIX;
+    filename += ".coverage.csv";
+
+    std::ofstream file(filename);
+
+    if (!file.is_open()) {
+      errs() << " Failed to open file: " << filename << "\n";
+    }
+    else {
+      auto write = [&file, &percent](Coverage &c, uint64_t total) {
+        file << c.name << "," << c.match << "," << c.asmCycles << ","
+             << c.statCycles << "," << c.appliedCycles << "," << c.calleeCycles
+             << "," << c.droppedLines << "," << c.droppedCycles << ","
+             << c.unmatchedLines << "," << c.unmatchedCycles << "," << c.blocks
+             << "," << c.lineBlocks << "," << c.rangeBlocks << ","
+             << c.unmatchedBlocks << "," << std::fixed << std::setprecision(1)
+             << percent(c.appliedCycles, total) << std::endl;
+      };
+
+      file << "function,match,asm,stat,applied,callee,dropped_lines,"
+              "dropped_cycles,unmatched_lines,unmatched_cycles,blocks,"
+              "line_blocks,range_blocks,unmatched_blocks,coverage"
+           << std::endl;
+
+      for (auto &c : coverages) {
+        write(c, getTotal(c));
+      }
+
+      // Last row summarizes module
+      sum.name = module.getName().data();
+      sum.match = "module";
+
+      write(sum, total);
+    }
+  }
+
+  // Fail the build when too many cycles are lost
+  if (minCoverage > 0 &&
+      (percent(sum.appliedCycles, total) < minCoverage || missing > 0)) {
+    std::string message;
+    raw_string_ostream os(message);
+
+    os << format("%.1f", percent(sum.appliedCycles, total))
+       << "% of " << total << " assembly cycles applied to "
+       << module.getName() << " (minimum " << minCoverage << "%), "
+       << missing << " marked functions not found in statistic file";
+
+    module.getContext().emitError(os.str());
+  }
 }
 
 void InstructionApplier::parseStatFile() {
   // State machine
-  // func -> at -> block -> number:
-  //   |             `--------|
-  //   `----------------------'
+  // [cpu]
+  // func -> at -> [asm] -> [call] -> block -> number:
+  //   |                               `--------|
+  //   `----------------------------------------'
 
   std::string line;
   enum STATE {
@@ -123,24 +1950,57 @@ void InstructionApplier::parseStatFile() {
   FuncStat *current = nullptr;
   BlockStat *bb = nullptr;
 
-  auto parseFile = [](std::string &line, std::string &file,
-                      size_t from) -> uint32_t {
+  auto parseFile = [this](std::string &line, const char *&file,
+                          size_t from) -> uint32_t {
     auto idx = line.find_last_of(':');
 
     if (idx == std::string::npos) {
       return 0;
     }
     else {
-      file = std::move(line.substr(from, idx - from));
+      file = strings->save(StringRef(line).slice(from, idx)).data();
 
       return strtoul(line.substr(idx + 1).c_str(), nullptr, 10);
     }
   };
 
+  // Counters of primary model, followed by ' | ' and counters of other models.
+  // Vector count (8th value) may be omitted
+  auto parseValues = [](const std::string &str,
+                        SmallVectorImpl<LineStat> &values) {
+    const char *ptr = str.c_str();
+    char *end = nullptr;
+    uint32_t i = 0;
+
+    values.assign(1, LineStat());
+
+    while (true) {
+      values.back()[i++] = strtoull(ptr, &end, 10);
+
+      if (*end == '\0') {
+        break;
+      }
+      else if (*end == ',') {
+        ptr = end + 2;
+      }
+      else {
+        values.emplace_back(LineStat());
+
+        ptr = end + 3;
+        i = 0;
+      }
+    }
+  };
+
   std::smatch match;
   std::regex regex_line(
-      "  (\\d+): (\\d+), (\\d+), (\\d+), (\\d+), (\\d+), (\\d+), (\\d+)");
+      "  (?:(.+):)?(\\d+): "
+      "(\\d+(?:, \\d+){6,7}(?: \\| \\d+(?:, \\d+){6,7})*)");
+  std::regex regex_call(
+      " call: (?:(.+):)?(\\d+): "
+      "(\\d+(?:, \\d+){6,7}(?: \\| \\d+(?:, \\d+){6,7})*)");
 
+  SmallVector<LineStat, 2> values;
   uint32_t linenumber;
 
   while (!infile.eof()) {
@@ -155,27 +2015,25 @@ void InstructionApplier::parseStatFile() {
         state = FUNC_AT;
       }
       else if (std::regex_match(line, match, regex_line)) {
-        // Expect '  %u:'
-        linenumber = strtoul(match[1].str().c_str(), nullptr, 10);
-
-        auto ret = current->lines.emplace(linenumber, LineStat());
-
-        ret.first->second.branch +=
-            strtoul(match[2].str().c_str(), nullptr, 10);
-        ret.first->second.load += strtoul(match[3].str().c_str(), nullptr, 10);
-        ret.first->second.store += strtoul(match[4].str().c_str(), nullptr, 10);
-        ret.first->second.arithmetic +=
-            strtoul(match[5].str().c_str(), nullptr, 10);
-        ret.first->second.floatingPoint +=
-            strtoul(match[6].str().c_str(), nullptr, 10);
-        ret.first->second.otherInsts +=
-            strtoul(match[7].str().c_str(), nullptr, 10);
-        ret.first->second.cycles +=
-            strtoul(match[8].str().c_str(), nullptr, 10);
+        // Expect '  %u:' or '  %s:%u:'
+        linenumber = strtoul(match[2].str().c_str(), nullptr, 10);
+
+        LineKey key(match[1].matched
+                        ? strings->save(StringRef(&*match[1].first,
+                                                 match[1].length()))
+                              .data()
+                        : current->file,
+                    linenumber);
+        parseValues(match[3].str(), values);
+
+        for (uint32_t m = 0; m < current->lines.size() && m < values.size();
+             m++) {
+          current->lines[m][key] += values[m];
+        }
 
         // Link to BB
         if (bb) {
-          bb->lines.emplace_back(linenumber);
+          bb->lines.emplace_back(key);
         }
 
         // No state change
@@ -189,8 +2047,49 @@ void InstructionApplier::parseStatFile() {
       }
     }
 
+    // End of file
+    if (state == IDLE && line.length() == 0) {
+      break;
+    }
+
     switch (state) {
       case IDLE: {
+        // Expect 'cpu: <CPU model names>' before any function
+        if (line.compare(0, 5, "cpu: ") == 0 && funclist.empty()) {
+          StringRef list(StringRef(line).substr(5));
+
+          while (!list.empty()) {
+            auto pair = list.split(' ');
+
+            if (!pair.first.empty()) {
+              models.emplace_back(strings->save(pair.first).data());
+            }
+
+            list = pair.second;
+          }
+
+          break;
+        }
+
+        // Expect 'memory: <copy>, <set>[ | <copy>, <set>...]' after cpu:
+        if (line.compare(0, 8, "memory: ") == 0 && funclist.empty()) {
+          SmallVector<StringRef, 2> list;
+
+          StringRef(line).substr(8).split(list, '|');
+
+          for (auto item : list) {
+            auto pair = item.split(',');
+            MemoryStat stat{8, 8};
+
+            pair.first.trim().getAsInteger(10, stat.copy);
+            pair.second.trim().getAsInteger(10, stat.set);
+
+            memorylist.emplace_back(stat);
+          }
+
+          break;
+        }
+
         // Expect 'func: <Function name>'
         if (line.compare(0, 6, "func: ") != 0) {
           return;
@@ -201,7 +2100,9 @@ void InstructionApplier::parseStatFile() {
         current = &funclist.back();
 
         // Store function name
-        current->name = std::move(line.substr(6));
+        current->name = strings->save(StringRef(line).substr(6)).data();
+        current->lines.resize(std::max<size_t>(models.size(), 1));
+        current->calls.resize(current->lines.size());
 
 #ifdef DEBUG_MODE
         outs() << "Function: " << current->name << "\n";
@@ -222,6 +2123,42 @@ void InstructionApplier::parseStatFile() {
 
         break;
       case FUNC_AT:
+        // Expect ' asm: <cycles>, <dropped lines>, <dropped cycles>'
+        if (line.compare(0, 6, " asm: ") == 0) {
+          SmallVector<StringRef, 3> list;
+
+          StringRef(line).substr(6).split(list, ',');
+
+          if (list.size() == 3) {
+            current->matched = true;
+
+            list[0].trim().getAsInteger(10, current->asmCycles);
+            list[1].trim().getAsInteger(10, current->droppedLines);
+            list[2].trim().getAsInteger(10, current->droppedCycles);
+          }
+
+          break;
+        }
+
+        // Expect ' call: <line>: <stats>' or ' call: <file>:<line>: <stats>'
+        if (std::regex_match(line, match, regex_call)) {
+          LineKey key(match[1].matched
+                          ? strings->save(StringRef(&*match[1].first,
+                                                   match[1].length()))
+                                .data()
+                          : current->file,
+                      strtoul(match[2].str().c_str(), nullptr, 10));
+
+          parseValues(match[3].str(), values);
+
+          for (uint32_t m = 0; m < current->calls.size() && m < values.size();
+               m++) {
+            current->calls[m][key] += values[m];
+          }
+
+          break;
+        }
+
         // Expect ' block: <basic block name>'
         if (line.compare(0, 8, " block: ") != 0) {
           return;
@@ -232,7 +2169,7 @@ void InstructionApplier::parseStatFile() {
         bb = &current->blocks.back();
 
         // Store basicblock name
-        bb->name = std::move(line.substr(8));
+        bb->name = strings->save(StringRef(line).substr(8)).data();
 
 #ifdef DEBUG_MODE
         outs() << " BasicBlock: " << bb->name << "\n";
@@ -246,9 +2183,37 @@ void InstructionApplier::parseStatFile() {
     }
   }
 
+  // Index line range of each block
+  for (auto &func : funclist) {
+    for (uint32_t i = 0; i < func.blocks.size(); i++) {
+      uint32_t first = std::numeric_limits<uint32_t>::max();
+      uint32_t last = 0;
+
+      for (auto &bbline : func.blocks[i].lines) {
+        if (bbline.file == func.file) {
+          first = std::min(first, bbline.line);
+          last = std::max(last, bbline.line);
+        }
+      }
+
+      if (last > 0) {
+        func.ranges.add(first, last, i);
+      }
+    }
+
+    func.ranges.build();
+  }
+
   inited = true;
 }
 
+void InstructionApplier::getAnalysisUsage(AnalysisUsage &usage) const {
+  if (edgeProfile || expectedCost) {
+    usage.addRequired<BlockFrequencyInfoWrapperPass>();
+    usage.addRequired<BranchProbabilityInfoWrapperPass>();
+  }
+}
+
 bool InstructionApplier::doInitialization(Module &module) {
   std::string filename(inputFile);
 
@@ -267,6 +2232,8 @@ bool InstructionApplier::doInitialization(Module &module) {
   infile.open(filename);
 
   if (infile.is_open()) {
+    strings = std::make_unique<UniqueStringSaver>(allocator);
+
     parseStatFile();
 
     filename += ".log";
@@ -287,8 +2254,9 @@ bool InstructionApplier::runOnFunction(Function &func) {
 
   Value *fstat = nullptr;
   Instruction *next = nullptr;
+  StructType *type = nullptr;
 
-  if (isMarked(func, &fstat, &next)) {
+  if (isMarked(func, &fstat, &next, &type)) {
 #ifdef DEBUG_MODE
     outs() << "Handling function: ";
 
@@ -298,17 +2266,21 @@ bool InstructionApplier::runOnFunction(Function &func) {
     outs() << fstat->getName() << ".\n";
 #endif
 
-    std::string ffile;
-    std::string file;
+    // Marker is removed, but no counter to update
+    if (level == Level::None) {
+      return true;
+    }
+
+    const DIFile *ffile = nullptr;
     uint32_t fline = 0;
-    uint32_t line;
 
     // Find function
     auto iter = funclist.begin();
+    const char *match = "name";
 
     // Match name
     for (; iter != funclist.end(); ++iter) {
-      if (iter->name.compare(func.getName().data()) == 0) {
+      if (func.getName() == iter->name) {
         break;
       }
     }
@@ -321,18 +2293,28 @@ bool InstructionApplier::runOnFunction(Function &func) {
 
       if (fline > 0) {
         for (iter = funclist.begin(); iter != funclist.end(); ++iter) {
-          if (iter->file.compare(ffile) == 0 && iter->at == fline) {
+          if (iter->file == getFileName(ffile) && iter->at == fline) {
             break;
           }
         }
       }
+
+      match = "at";
     }
 
+    coverages.emplace_back(Coverage());
+
+    auto &coverage = coverages.back();
+
+    coverage.name = strings->save(func.getName()).data();
+    coverage.match = iter != funclist.end() ? match : "none";
+
     if (iter != funclist.end()) {
       auto &funcstat = *iter;
 
-      // Setup pointers of fstat
-      makePointers(next, fstat);
+      coverage.asmCycles = funcstat.asmCycles;
+      coverage.droppedLines = funcstat.droppedLines;
+      coverage.droppedCycles = funcstat.droppedCycles;
 
       // Log result if possible
       if (resultfile.is_open()) {
@@ -340,117 +2322,162 @@ bool InstructionApplier::runOnFunction(Function &func) {
 
         // Only print when file info is valid
         if (fline > 0) {
-          resultfile << " at: " << ffile << ":" << fline << std::endl;
+          resultfile << " at: " << getFileName(ffile) << ":" << fline
+                     << std::endl;
         }
       }
 
-      // Apply instruction stats ...
-      for (auto &block : func) {
-        // Total stat of current basic block
-        LineStat sum;
+      // CPU::Function of older SimpleSSD has no vector counter
+      vectorCounter = !shard && type &&
+                      type->getNumElements() > (uint32_t)Counter::Vector;
 
-        // Where we need to insert stats
-        auto &last = block.back();
+      // Statistics of each basic block, for each CPU model
+      std::vector<std::unordered_map<BasicBlock *, LineStat>> costs(
+          multiCPU ? funcstat.lines.size() : 1);
+      auto &blockstats = costs.front();
 
-        // ... from each lines
-        for (auto &inst : block) {
-          // Get line info
-          line = getLineInfo(inst, file);
+      for (uint32_t m = 0; m < costs.size(); m++) {
+        collectBlockStats(func, funcstat, m, costs[m],
+                          m == 0 ? &coverage : nullptr);
+      }
 
-          if (line > 0 && ffile.compare(file) == 0) {
-            // Find line from database
-            auto stat = funcstat.lines.find(line);
+      auto entry = next->getParent();
+      bool sampled = false;
 
-            if (stat != funcstat.lines.end() && stat->second.cycles > 0) {
-              // Sum stat value to sum
-              sum.branch += stat->second.branch;
-              sum.load += stat->second.load;
-              sum.store += stat->second.store;
-              sum.arithmetic += stat->second.arithmetic;
-              sum.floatingPoint += stat->second.floatingPoint;
-              sum.otherInsts += stat->second.otherInsts;
-              sum.cycles += stat->second.cycles;
+      // Edge counts are only folded at ret/resume, so invocation leaving
+      // through other way loses all counts - use per-block counters instead
+      bool earlyExit = edgeProfile && hasEarlyExit(entry);
 
-              stat->second.cycles = 0;
-            }
-          }
-        }
+      // Static cost of each block for block profile, kept before expected
+      // cost moves everything to entry
+      std::unordered_map<BasicBlock *, LineStat> profilestats;
 
-        if (sum.cycles == 0) {
-          // Current block does not have line information, use old method
-          uint32_t begin = getFirstLine(block, file);
-          uint32_t end = getLastLine(block, file);
+      if (blockProfile) {
+        profilestats = blockstats;
+      }
 
-          for (auto &bbstat : funcstat.blocks) {
-            if (bbstat.lines.size() == 0) {
-              continue;
-            }
+      // Replace per-block updates with one update at entry
+      if (expectedCost) {
+        for (auto &stats : costs) {
+          auto sum = getExpectedCost(func, stats);
 
-            // Sort lines
-            std::sort(bbstat.lines.begin(), bbstat.lines.end());
-
-            // Match
-            if (bbstat.lines.front() <= begin && end <= bbstat.lines.back()) {
-              for (auto &bbline : bbstat.lines) {
-                auto bblinestat = funcstat.lines.find(bbline);
-
-                if (bblinestat != funcstat.lines.end() &&
-                    bblinestat->second.cycles > 0) {
-                  // Sum stat value to sum
-                  sum.branch += bblinestat->second.branch;
-                  sum.load += bblinestat->second.load;
-                  sum.store += bblinestat->second.store;
-                  sum.arithmetic += bblinestat->second.arithmetic;
-                  sum.floatingPoint += bblinestat->second.floatingPoint;
-                  sum.otherInsts += bblinestat->second.otherInsts;
-                  sum.cycles += bblinestat->second.cycles;
-
-                  bblinestat->second.cycles = 0;
-                }
-              }
-
-              break;
-            }
+          if (resultfile.is_open() && &stats == &blockstats) {
+            resultfile << " Expected: " << sum.branch << ", " << sum.load
+                       << ", " << sum.store << ", " << sum.arithmetic << ", "
+                       << sum.floatingPoint << ", " << sum.otherInsts << ", "
+                       << sum.cycles << ", " << sum.vector << std::endl;
           }
 
-          if (sum.cycles == 0) {
-            // Giving up
-            continue;
-          }
+          stats.clear();
+          stats.emplace(entry, sum);
         }
+      }
 
-        // Log result if possible
-        if (resultfile.is_open()) {
-          resultfile << " BasicBlock: " << block.getName().data() << std::endl;
-          resultfile << "  Stat: " << sum.branch << ", " << sum.load << ", "
-                     << sum.store << ", " << sum.arithmetic << ", "
-                     << sum.floatingPoint << ", " << sum.otherInsts << ", "
-                     << sum.cycles << std::endl;
-        }
+      // Keep uninstrumented copy of function body
+      if (sampleRate > 1 || runtimeSwitch) {
+        auto plain = cloneBody(func, next);
 
-        if (sum.branch > 0) {
-          makeAdd(&last, pointers.branch, sum.branch);
-        }
-        if (sum.load > 0) {
-          makeAdd(&last, pointers.load, sum.load);
-        }
-        if (sum.store > 0) {
-          makeAdd(&last, pointers.store, sum.store);
-        }
-        if (sum.arithmetic > 0) {
-          makeAdd(&last, pointers.arithmetic, sum.arithmetic);
+        if (plain) {
+          makeDispatch(func, next, plain);
+
+          sampled = sampleRate > 1;
         }
-        if (sum.floatingPoint > 0) {
-          makeAdd(&last, pointers.floating, sum.floatingPoint);
+        else {
+          // Every invocation is counted and cannot be switched off
+          errs() << "Warning: Function: ";
+          printFunctionName(errs(), func);
+          errs() << " has block with address taken, sampling and runtime "
+                    "switch are disabled.\n";
+
+          if (resultfile.is_open()) {
+            resultfile << " NoClone: block with address taken" << std::endl;
+          }
         }
-        if (sum.otherInsts > 0) {
-          makeAdd(&last, pointers.other, sum.otherInsts);
+      }
+
+      // Memory accesses of function body, without instrumentation
+      std::vector<Instruction *> accesses;
+      std::vector<Instruction *> calls;
+
+      if (cacheModel) {
+        getMemoryAccesses(next->getParent(), accesses, calls);
+      }
+
+      // Setup pointers of fstat
+      if (shard) {
+        makeShardPointers(next);
+      }
+      else {
+        makePointers(next, fstat, type);
+      }
+
+      // Entry block may be splitted while making pointers
+      if (next->getParent() != entry) {
+        auto move = [&](std::unordered_map<BasicBlock *, LineStat> &stats) {
+          auto stat = stats.find(entry);
+
+          if (stat != stats.end()) {
+            stats.emplace(next->getParent(), stat->second);
+            stats.erase(stat);
+          }
+        };
+
+        for (auto &stats : costs) {
+          move(stats);
         }
-        if (sum.cycles > 0) {
-          makeAdd(&last, pointers.cycles, sum.cycles);
+
+        move(profilestats);
+      }
+
+      // Apply instruction stats
+      if (costs.size() > 1) {
+        applyCostTable(func, costs);
+      }
+      else if (!edgeProfile || expectedCost || earlyExit ||
+               !applyEdgeProfile(func, next, blockstats)) {
+        for (auto &block : func) {
+          auto stat = blockstats.find(&block);
+
+          if (stat != blockstats.end()) {
+            applyBlock(block, stat->second);
+          }
         }
       }
 
+      // Length-based cost of memory routines
+      if (memoryCost) {
+        makeMemoryCost(func, next, costs.size() > 1);
+      }
+
+      // Count executions of each block
+      if (blockProfile) {
+        makeBlockProfile(func, next, profilestats);
+      }
+
+      // Simulate branch predictor
+      if (branchModel) {
+        makeBranchModel(func, next);
+      }
+
+      // Simulate data cache (after branch model - adds branches)
+      if (cacheModel) {
+        makeCacheModel(func, next, accesses, calls);
+      }
+
+      // Report sampled invocations
+      if (sampled) {
+        makeSampleRecord(func, next);
+      }
+
+      // Record latency of each invocation
+      if (trace) {
+        makeTrace(func, next);
+      }
+
+      if (histogram) {
+        makeHistogram(func, next);
+      }
+
       // Verify function
       if (verifyFunction(func, &errs())) {
         func.dump();
@@ -470,16 +2497,30 @@ bool InstructionApplier::runOnFunction(Function &func) {
   return false;
 }
 
-bool InstructionApplier::doFinalization(Module &) {
+bool InstructionApplier::doFinalization(Module &module) {
   if (inited) {
     infile.close();
 
     if (resultfile.is_open()) {
       resultfile.close();
     }
+
+    saveCoverage(module);
   }
 
   inited = false;
+  ctor = nullptr;
+  cpuModel = nullptr;
+  memoryTable = nullptr;
+
+  // Free parsed statistics at once
+  funclist.clear();
+  models.clear();
+  memorylist.clear();
+  coverages.clear();
+  files.clear();
+  strings.reset();
+  allocator.Reset();
 
   return false;
 }
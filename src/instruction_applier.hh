@@ -11,15 +11,42 @@
 #define __SRC_INSTRUCTION_APPLIER_HH__
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
+#include "src/interval_index.hh"
+#include "src/line_key.hh"
 #include "src/util.hh"
 
 namespace SimpleSSD::LLVM {
 
+enum class Level : uint8_t {
+  None,        // No counter
+  Cycles,      // Cycles only
+  Categories,  // Cycles + branch, load and store
+  Full,        // All counters
+};
+
+enum Counter : uint32_t {
+  Branch,
+  Load,
+  Store,
+  Arithmetic,
+  FloatingPoint,
+  Other,
+  Cycles,
+  Vector,  // Only if CPU::Function has this field, otherwise added to Other
+  CounterCount,
+};
+
 struct LineStat {
   // Instruction count
   uint64_t branch;
@@ -32,6 +59,9 @@ struct LineStat {
   // Cycle consumed
   uint64_t cycles;
 
+  // Advanced SIMD and crypto instruction count
+  uint64_t vector;
+
   LineStat()
       : branch(0),
         load(0),
@@ -39,22 +69,111 @@ struct LineStat {
         arithmetic(0),
         floatingPoint(0),
         otherInsts(0),
-        cycles(0) {}
+        cycles(0),
+        vector(0) {}
+
+  uint64_t &operator[](uint32_t idx) {
+    switch (idx) {
+      case Counter::Branch:
+        return branch;
+      case Counter::Load:
+        return load;
+      case Counter::Store:
+        return store;
+      case Counter::Arithmetic:
+        return arithmetic;
+      case Counter::FloatingPoint:
+        return floatingPoint;
+      case Counter::Other:
+        return otherInsts;
+      case Counter::Vector:
+        return vector;
+      default:
+        return cycles;
+    }
+  }
+
+  //! Take 1/parts of this, leaving remainder
+  LineStat split(uint32_t parts) {
+    LineStat ret;
+
+    for (uint32_t i = 0; i < Counter::CounterCount; i++) {
+      ret[i] = (*this)[i] / parts;
+      (*this)[i] -= ret[i];
+    }
+
+    return ret;
+  }
+
+  LineStat &operator+=(const LineStat &rhs) {
+    branch += rhs.branch;
+    load += rhs.load;
+    store += rhs.store;
+    arithmetic += rhs.arithmetic;
+    floatingPoint += rhs.floatingPoint;
+    otherInsts += rhs.otherInsts;
+    cycles += rhs.cycles;
+    vector += rhs.vector;
+
+    return *this;
+  }
 };
 
+// Bytes per cycle of library routines, of one CPU model
+struct MemoryStat {
+  uint64_t copy;  // memcpy, memmove
+  uint64_t set;   // memset
+};
+
+// Names are allocated in arena of InstructionApplier
 struct BlockStat {
-  std::string name;
+  const char *name;
 
-  std::vector<uint32_t> lines;
+  llvm::SmallVector<LineKey, 8> lines;
 };
 
 struct FuncStat {
-  std::string name;
-  std::string file;
+  const char *name;
+  const char *file;  // Interned
   uint32_t at;
 
   std::vector<BlockStat> blocks;
-  std::unordered_map<uint32_t, LineStat> lines;
+
+  // Line statistics of each CPU model, primary model first
+  std::vector<llvm::DenseMap<LineKey, LineStat>> lines;
+
+  // Static cost of unmarked callees, by line of call remaining in assembly
+  std::vector<llvm::DenseMap<LineKey, LineStat>> calls;
+
+  // Line range of blocks in function file, for fallback matching
+  IntervalIndex ranges;
+
+  // Assembly of function (asm: line), primary model
+  bool matched;
+  uint64_t asmCycles;
+  uint32_t droppedLines;  // Dropped by generator, no IR counterpart
+  uint64_t droppedCycles;
+};
+
+// Matching quality of one marked function, primary model
+struct Coverage {
+  const char *name;
+  const char *match;  // How function is found: name, at or none
+
+  uint64_t asmCycles;      // Every instruction of assembly function
+  uint64_t statCycles;     // Lines of statistic file
+  uint64_t appliedCycles;  // Charged to IR blocks, without callees
+  uint64_t calleeCycles;   // Static cost of unmarked callees
+
+  uint32_t droppedLines;  // No IR counterpart in generator
+  uint64_t droppedCycles;
+  uint32_t unmatchedLines;  // In statistic file, but not charged
+  uint64_t unmatchedCycles;
+
+  uint32_t blocks;           // IR blocks of function
+  uint32_t lineBlocks;       // Matched by line info of instructions
+  uint32_t rangeBlocks;      // Matched by line range (fallback)
+  uint32_t unmatchedBlocks;  // No cost
 };
 
 /**
@@ -72,26 +191,85 @@ class InstructionApplier : public llvm::FunctionPass, Utility {
   std::ofstream resultfile;
   std::vector<FuncStat> funclist;
 
-  struct {
-    llvm::Value *branch;
-    llvm::Value *load;
-    llvm::Value *store;
-    llvm::Value *arithmetic;
-    llvm::Value *floating;
-    llvm::Value *other;
-    llvm::Value *cycles;
-  } pointers;
-
-  void makePointers(llvm::Instruction *, llvm::Value *);
+  // CPU models of statistic file (cpu: line), empty if not specified
+  std::vector<const char *> models;
+
+  // Memory routine throughput of each CPU model (memory: line)
+  std::vector<MemoryStat> memorylist;
+
+  // Matching quality of marked functions, in order of handling
+  std::vector<Coverage> coverages;
+
+  // Arena of parsed statistics, freed in doFinalization
+  llvm::BumpPtrAllocator allocator;
+  std::unique_ptr<llvm::UniqueStringSaver> strings;
+  llvm::DenseMap<const llvm::DIFile *, const char *> files;
+
+  const char *getFileName(const llvm::DIFile *);
+
+  llvm::Value *pointers[Counter::CounterCount];
+
+  // Counter::Vector is updated, instead of Counter::Other
+  bool vectorCounter;
+
+  // Module constructor registering functions to runtime
+  llvm::Function *ctor;
+
+  // Index of active CPU model, set by runtime
+  llvm::GlobalVariable *cpuModel;
+
+  // MemoryStat of each CPU model
+  llvm::GlobalVariable *memoryTable;
+
+  void makePointers(llvm::Instruction *, llvm::Value *, llvm::StructType *);
+  void makeShardPointers(llvm::Instruction *);
+  llvm::Instruction *getCtor(llvm::Module &);
+  llvm::GlobalVariable *getCPUModel(llvm::Module &);
   void makeAdd(llvm::Instruction *, llvm::Value *, uint64_t);
+  void makeAdd(llvm::Instruction *, llvm::Value *, llvm::Value *);
+  void makeUpdateCount(llvm::Instruction *);
+
+  void getRegion(llvm::BasicBlock *, std::vector<llvm::BasicBlock *> &);
+  void getExits(llvm::BasicBlock *, std::vector<llvm::Instruction *> &);
+  bool hasEarlyExit(llvm::BasicBlock *);
+  llvm::BasicBlock *cloneBody(llvm::Function &, llvm::Instruction *);
+  void makeDispatch(llvm::Function &, llvm::Instruction *, llvm::BasicBlock *);
+  void makeSampleRecord(llvm::Function &, llvm::Instruction *);
+  void makeTrace(llvm::Function &, llvm::Instruction *);
+  void makeHistogram(llvm::Function &, llvm::Instruction *);
+  void makeBranchModel(llvm::Function &, llvm::Instruction *);
+  void makeMemoryCost(llvm::Function &, llvm::Instruction *, bool);
+  void getMemoryAccesses(llvm::BasicBlock *,
+                         std::vector<llvm::Instruction *> &,
+                         std::vector<llvm::Instruction *> &);
+  void makeCacheModel(llvm::Function &, llvm::Instruction *,
+                      std::vector<llvm::Instruction *> &,
+                      std::vector<llvm::Instruction *> &);
+
+  void collectBlockStats(llvm::Function &, FuncStat &, uint32_t,
+                         std::unordered_map<llvm::BasicBlock *, LineStat> &,
+                         Coverage *);
+  void applyBlock(llvm::BasicBlock &, LineStat &);
+  void applyCostTable(
+      llvm::Function &,
+      std::vector<std::unordered_map<llvm::BasicBlock *, LineStat>> &);
+  LineStat getExpectedCost(llvm::Function &,
+                           std::unordered_map<llvm::BasicBlock *, LineStat> &);
+  void makeBlockProfile(llvm::Function &, llvm::Instruction *,
+                        std::unordered_map<llvm::BasicBlock *, LineStat> &);
+  bool applyEdgeProfile(llvm::Function &, llvm::Instruction *,
+                        std::unordered_map<llvm::BasicBlock *, LineStat> &);
 
   void parseStatFile();
+  void saveCoverage(llvm::Module &);
 
  public:
   static char ID;
 
   InstructionApplier();
 
+  void getAnalysisUsage(llvm::AnalysisUsage &) const override;
+
   bool doInitialization(llvm::Module &) override;
   bool runOnFunction(llvm::Function &) override;
   bool doFinalization(llvm::Module &) override;
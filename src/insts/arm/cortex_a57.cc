@@ -7,6 +7,11 @@
 
 #include "src/insts/arm/cortex_a57.hh"
 
+#include <strings.h>
+
+#include <cctype>
+#include <cstring>
+
 namespace Instruction::ARM {
 
 RuleList rule_a57 = {
@@ -88,12 +93,12 @@ RuleList rule_a57 = {
     {'S', {"SMADDL", Type::Arithmetic, 3}},
     {'S', {"SMSUBL", Type::Arithmetic, 3}},
     {'S', {"SMNEGL", Type::Arithmetic, 3}},
-    {'S', {"SMULL", Type::Arithmetic, 3}},
+    {'S', {"SMULL2?", Type::Arithmetic, 3}},
     {'S', {"SMULH", Type::Arithmetic, 6}},
     {'U', {"UMADDL", Type::Arithmetic, 3}},
     {'U', {"UMSUBL", Type::Arithmetic, 3}},
     {'U', {"UMNEGL", Type::Arithmetic, 3}},
-    {'U', {"UMULL", Type::Arithmetic, 3}},
+    {'U', {"UMULL2?", Type::Arithmetic, 3}},
     {'U', {"UMULH", Type::Arithmetic, 6}},
     {'S', {"SDIV", Type::Arithmetic, 20}},
     {'U', {"UDIV", Type::Arithmetic, 20}},
@@ -136,9 +141,263 @@ RuleList rule_a57 = {
     {'F', {"FMINNM", Type::FloatingPoint, 5}},
     {'F', {"FCMP(E|P|PE|)", Type::FloatingPoint, 3}},
     {'F', {"FCSEL", Type::FloatingPoint, 3}},
+    // Scalar forms of ASIMD FP compare, absolute difference and multiply
+    // extended, vector forms are counted as vector in adjust()
+    {'F', {"FCM(EQ|GE|GT|LE|LT)", Type::FloatingPoint, 5}},
+    {'F', {"FAC(GE|GT)", Type::FloatingPoint, 5}},
+    {'F', {"FABD", Type::FloatingPoint, 5}},
+    {'F', {"FMULX", Type::FloatingPoint, 6}},
+    {'C', {"CRC32C?(B|H|W|X)", Type::Arithmetic, 3}},
+    // Advanced SIMD and crypto, latency from Cortex-A57 Software Optimization
+    // Guide. Mnemonics shared with scalar instructions (ADD, MOV, ...) are
+    // counted as scalar.
+    {'L', {"LD1", Type::Load, 5}},
+    {'L', {"LD1R", Type::Load, 8}},
+    {'L', {"LD2R?", Type::Load, 8}},
+    {'L', {"LD3R?", Type::Load, 9}},
+    {'L', {"LD4R?", Type::Load, 9}},
+    {'S', {"ST1", Type::Store, 1}},
+    {'S', {"ST2", Type::Store, 2}},
+    {'S', {"ST3", Type::Store, 3}},
+    {'S', {"ST4", Type::Store, 4}},
+    {'A', {"ABS", Type::Vector, 3}},
+    {'A', {"ADDP", Type::Vector, 3}},
+    {'A', {"ADDV", Type::Vector, 4}},
+    {'A', {"ADDHN2?", Type::Vector, 3}},
+    {'B', {"B(SL|IT|IF)", Type::Vector, 3}},
+    {'C', {"CM(EQ|GE|GT|HI|HS|LE|LT|TST)", Type::Vector, 3}},
+    {'C', {"CNT", Type::Vector, 3}},
+    {'D', {"DUP", Type::Vector, 3}},
+    {'E', {"EXT", Type::Vector, 3}},
+    {'I', {"INS", Type::Vector, 3}},
+    {'M', {"MOVI", Type::Vector, 3}},
+    {'M', {"MVNI", Type::Vector, 3}},
+    {'M', {"ML(A|S)", Type::Vector, 5}},
+    {'N', {"NOT", Type::Vector, 3}},
+    {'P', {"PMUL", Type::Vector, 5}},
+    {'P', {"PMULL2?", Type::Vector, 3}},
+    {'R', {"R(ADD|SUB)HN2?", Type::Vector, 3}},
+    {'R', {"RSHRN2?", Type::Vector, 3}},
+    {'S', {"SHL", Type::Vector, 3}},
+    {'S', {"SHRN2?", Type::Vector, 3}},
+    {'S', {"SUBHN2?", Type::Vector, 3}},
+    {'S', {"S(LI|RI)", Type::Vector, 3}},
+    {'S', {"SMOV", Type::Vector, 5}},
+    {'S', {"SQ(ABS|NEG)", Type::Vector, 3}},
+    {'S', {"SQR?DMULH", Type::Vector, 5}},
+    {'S', {"SQDML(A|S)L2?", Type::Vector, 5}},
+    {'S', {"SQDMULL2?", Type::Vector, 5}},
+    {'S', {"SQXTU?N2?", Type::Vector, 4}},
+    {'U', {"UMOV", Type::Vector, 5}},
+    {'U', {"UQXTN2?", Type::Vector, 4}},
+    {'U', {"UR(ECPE|SQRTE)", Type::Vector, 3}},
+    {'T', {"TB(L|X)", Type::Vector, 3}},
+    {'T', {"TRN(1|2)", Type::Vector, 3}},
+    {'U', {"UZP(1|2)", Type::Vector, 3}},
+    {'Z', {"ZIP(1|2)", Type::Vector, 3}},
+    {'X', {"XTN2?", Type::Vector, 3}},
+    {'F', {"FML(A|S)", Type::Vector, 9}},
+    {'F', {"FADDP", Type::Vector, 5}},
+    {'F', {"F(MAX|MIN)(NM)?P", Type::Vector, 5}},
+    {'F', {"F(MAX|MIN)(NM)?V", Type::Vector, 9}},
+    {'F', {"FCVT(L|N)2?", Type::Vector, 8}},
+    {'F', {"FCVTXN2", Type::Vector, 8}},
+    {'F', {"FR(ECP|SQRT)E", Type::FloatingPoint, 5}},
+    {'F', {"FRECPX", Type::FloatingPoint, 5}},
+    {'F', {"FR(ECP|SQRT)S", Type::FloatingPoint, 9}},
+    {'S', {"S(ABD|ABDL2?)", Type::Vector, 3}},
+    {'U', {"U(ABD|ABDL2?)", Type::Vector, 3}},
+    {'S', {"SABAL?2?", Type::Vector, 4}},
+    {'U', {"UABAL?2?", Type::Vector, 4}},
+    {'S', {"S(ADD|SUB)(L|W)2?", Type::Vector, 3}},
+    {'U', {"U(ADD|SUB)(L|W)2?", Type::Vector, 3}},
+    {'S', {"SR?H(ADD|SUB)", Type::Vector, 3}},
+    {'U', {"UR?H(ADD|SUB)", Type::Vector, 3}},
+    {'S', {"SQ(ADD|SUB)", Type::Vector, 3}},
+    {'U', {"UQ(ADD|SUB)", Type::Vector, 3}},
+    {'S', {"SUQADD", Type::Vector, 3}},
+    {'U', {"USQADD", Type::Vector, 3}},
+    {'S', {"S(MAX|MIN)P?", Type::Vector, 3}},
+    {'U', {"U(MAX|MIN)P?", Type::Vector, 3}},
+    {'S', {"S(ADDL|MAX|MIN)V", Type::Vector, 4}},
+    {'U', {"U(ADDL|MAX|MIN)V", Type::Vector, 4}},
+    {'S', {"SADDLP", Type::Vector, 3}},
+    {'U', {"UADDLP", Type::Vector, 3}},
+    {'S', {"SADALP", Type::Vector, 4}},
+    {'U', {"UADALP", Type::Vector, 4}},
+    {'S', {"SML(A|S)L2?", Type::Vector, 5}},
+    {'U', {"UML(A|S)L2?", Type::Vector, 5}},
+    {'S', {"SR?SHR", Type::Vector, 3}},
+    {'U', {"UR?SHR", Type::Vector, 3}},
+    {'S', {"SR?SRA", Type::Vector, 4}},
+    {'U', {"UR?SRA", Type::Vector, 4}},
+    {'S', {"SR?SHL", Type::Vector, 3}},
+    {'U', {"UR?SHL", Type::Vector, 3}},
+    {'S', {"S(SHLL|XTL)2?", Type::Vector, 3}},
+    {'U', {"U(SHLL|XTL)2?", Type::Vector, 3}},
+    {'S', {"SQR?SHLU?", Type::Vector, 4}},
+    {'U', {"UQR?SHL", Type::Vector, 4}},
+    {'S', {"SQR?SHRU?N2?", Type::Vector, 4}},
+    {'U', {"UQR?SHRN2?", Type::Vector, 4}},
+    {'A', {"AES(E|D|MC|IMC)", Type::Vector, 3}},
+    {'S', {"SHA1(C|M|P)", Type::Vector, 9}},
+    {'S', {"SHA1H", Type::Vector, 3}},
+    {'S', {"SHA1SU0", Type::Vector, 6}},
+    {'S', {"SHA1SU1", Type::Vector, 3}},
+    {'S', {"SHA256H2?", Type::Vector, 9}},
+    {'S', {"SHA256SU0", Type::Vector, 3}},
+    {'S', {"SHA256SU1", Type::Vector, 6}},
+};
+
+static const auto flags = std::regex::ECMAScript | std::regex::icase;
+
+static std::regex regex_vector("v\\d+\\.\\d*[bhsd](\\[\\d+\\])?", flags);
+static std::regex regex_alu_shift("(ADD|SUB|CMP|CMN|NEG)S?|ANDS|BICS|TST",
+                                  flags);
+static std::regex regex_multiply("MADD|MSUB|MNEG|MUL", flags);
+static std::regex regex_divide("(S|U)DIV", flags);
+static std::regex regex_vector_multiply("MUL|ML(A|S)|(S|U)MULL2?", flags);
+static std::regex regex_pair("STN?P", flags);
+
+struct Address {
+  bool scaled;     // Register offset with shift or extend
+  bool writeback;  // Pre- or post-index
 };
 
-Type CortexA57::getStatistic(std::string &op, uint64_t &cycles) {
+static bool isShift(const std::string &operand) {
+  static const char *list[] = {"lsl", "lsr", "asr", "ror", "uxt", "sxt"};
+
+  for (auto prefix : list) {
+    if (strncasecmp(operand.c_str(), prefix, 3) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static Address getAddress(Operands &operands) {
+  Address ret{false, false};
+
+  for (size_t i = 0; i < operands.size(); i++) {
+    auto &operand = operands[i];
+
+    if (operand.front() != '[') {
+      continue;
+    }
+
+    // [base, offset, shift/extend]
+    Operands parts;
+
+    parseOperands(operand.substr(1, operand.find(']') - 1), parts);
+
+    ret.scaled = parts.size() > 2 && isShift(parts[2]);
+
+    // [base, #imm]! or [base], #imm
+    ret.writeback = operand.back() == '!' || i + 1 < operands.size();
+
+    break;
+  }
+
+  return ret;
+}
+
+// Register file of operand: w, x, b, h, s, d, q or v
+static char getWidth(const std::string &operand) {
+  char c = tolower(operand.front());
+
+  return c == 's' && tolower(operand[1]) == 'p' ? 'x' : c;
+}
+
+/**
+ * Adjust cycles by addressing mode, register width and shift/extend
+ *
+ * Check instruction characteristics tables of ARM Cortex-A57 Software
+ * Optimization Guide.
+ */
+static void adjust(std::string &op, Operands &operands, Type &type,
+                   uint64_t &cycles) {
+  if (operands.size() == 0) {
+    return;
+  }
+
+  char width = getWidth(operands.front());
+  bool vector = false;
+
+  for (auto &operand : operands) {
+    if (std::regex_match(operand, regex_vector)) {
+      vector = true;
+
+      break;
+    }
+  }
+
+  switch (type) {
+    case Type::Load:
+    case Type::Store: {
+      auto address = getAddress(operands);
+
+      // Load to FP/ASIMD register
+      if (type == Type::Load && strchr("bhsdq", width)) {
+        cycles += 1;
+      }
+
+      // Store pair of Q registers takes two cycles
+      if (type == Type::Store && width == 'q' &&
+          std::regex_match(op, regex_pair)) {
+        cycles += 1;
+      }
+
+      // Extra address generation
+      if (address.scaled) {
+        cycles += 1;
+      }
+
+      // Extra micro-op updating base register
+      if (address.writeback) {
+        cycles += 1;
+      }
+    } break;
+    case Type::Arithmetic: {
+      auto &last = operands.back();
+
+      if (vector) {
+        // Shares mnemonic with scalar instruction
+        type = Type::Vector;
+        cycles = std::regex_match(op, regex_vector_multiply) ? 5 : 3;
+      }
+      else if (width == 'x' && std::regex_match(op, regex_multiply)) {
+        cycles = 5;
+      }
+      else if (width == 'x' && std::regex_match(op, regex_divide)) {
+        cycles = 36;
+      }
+      else if (operands.size() > 2 && isShift(last) &&
+               operands[operands.size() - 2].front() != '#' &&
+               std::regex_match(op, regex_alu_shift)) {
+        // Shifted or extended register, not shifted immediate
+        cycles = 2;
+      }
+    } break;
+    case Type::FloatingPoint:
+      if (vector) {
+        type = Type::Vector;
+      }
+      else if (strncasecmp(op.c_str(), "fdiv", 4) == 0) {
+        cycles = width == 'd' ? 18 : 11;
+      }
+      else if (strncasecmp(op.c_str(), "fsqrt", 5) == 0) {
+        cycles = width == 'd' ? 32 : 17;
+      }
+
+      break;
+    default:
+      break;
+  }
+}
+
+Type CortexA57::getStatistic(std::string &op, Operands &operands,
+                             uint64_t &cycles) {
   char first = op.front();
   char other = first < 'a' ? first + ('a' - 'A') : first - ('a' - 'A');
 
@@ -152,9 +411,13 @@ Type CortexA57::getStatistic(std::string &op, uint64_t &cycles) {
 
     for (auto iter = range.first; iter != range.second; ++iter) {
       if (std::regex_match(op, match, iter->second.regex)) {
+        auto type = iter->second.type;
+
         cycles = iter->second.cycle;
 
-        return iter->second.type;
+        adjust(op, operands, type, cycles);
+
+        return type;
       }
     }
   }
@@ -162,4 +425,12 @@ Type CortexA57::getStatistic(std::string &op, uint64_t &cycles) {
   return Type::Ignore;
 }
 
+bool CortexA57::isCall(std::string &op) {
+  return strcasecmp(op.c_str(), "bl") == 0;
+}
+
+bool CortexA57::isTailCall(std::string &op) {
+  return strcasecmp(op.c_str(), "b") == 0;
+}
+
 }  // namespace Instruction::ARM
@@ -22,8 +22,14 @@ namespace Instruction::ARM {
  */
 class CortexA57 : public Base {
  public:
-  Type getStatistic(std::string &, uint64_t &) override;
+  Type getStatistic(std::string &, Operands &, uint64_t &) override;
+  bool isCall(std::string &) override;
+  bool isTailCall(std::string &) override;
   const char *getName() override { return "cortex-a57"; }
+
+  // One 128-bit load and one 128-bit store per cycle (LDP/STP of Q)
+  uint32_t getCopyBandwidth() override { return 16; }
+  uint32_t getSetBandwidth() override { return 16; }
 };
 
 }  // namespace Instruction::ARM
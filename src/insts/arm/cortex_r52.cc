@@ -7,6 +7,8 @@
 
 #include "src/insts/arm/cortex_r52.hh"
 
+#include <strings.h>
+
 #include <iostream>
 
 namespace Instruction::ARM {
@@ -185,99 +187,106 @@ RuleList rule_r52 = {
     {'U', {"UXTB", Type::Arithmetic, 1}},
     {'U', {"UXTB16", Type::Arithmetic, 1}},
     {'U', {"UXTH", Type::Arithmetic, 1}},
-    {'V', {"VABAL?", Type::Other, 2}},
-    {'V', {"VABDL?", Type::Other, 1}},
-    {'V', {"VABS", Type::Other, 1}},
-    {'V', {"VACG(E|T)", Type::Other, 1}},
-    {'V', {"VADD", Type::Other, 1}},
-    {'V', {"VADDHN", Type::Other, 1}},
-    {'V', {"VADDL", Type::Other, 1}},
-    {'V', {"VADDW", Type::Other, 1}},
-    {'V', {"VAND", Type::Other, 1}},
-    {'V', {"VBI(C|F|T)", Type::Other, 1}},
-    {'V', {"VBSL", Type::Other, 1}},
-    {'V', {"VC(EQ|GE|GT|LE|LS|LT|LZ|MP|MPE|NT)", Type::Other, 1}},
-    {'V', {"VCVT(A|B|M|N|P|R|T)?", Type::Other, 1}},
-    {'V', {"VDIV", Type::Other, 1}},
-    {'V', {"VDUP", Type::Other, 1}},
-    {'V', {"VEOR", Type::Other, 1}},
-    {'V', {"VEXT", Type::Other, 1}},
-    {'V', {"VFMA", Type::Other, 1}},
-    {'V', {"VFMS", Type::Other, 1}},
-    {'V', {"VFNMA", Type::Other, 1}},
-    {'V', {"VFNMS", Type::Other, 1}},
-    {'V', {"VHADD", Type::Other, 1}},
-    {'V', {"VHSUB", Type::Other, 1}},
+    {'V', {"VABAL?", Type::Vector, 2}},
+    {'V', {"VABDL?", Type::Vector, 1}},
+    {'V', {"VABS", Type::FloatingPoint, 1}},
+    {'V', {"VACG(E|T)", Type::Vector, 1}},
+    {'V', {"VADD", Type::FloatingPoint, 1}},
+    {'V', {"VADDHN", Type::Vector, 1}},
+    {'V', {"VADDL", Type::Vector, 1}},
+    {'V', {"VADDW", Type::Vector, 1}},
+    {'V', {"VAND", Type::Vector, 1}},
+    {'V', {"VBI(C|F|T)", Type::Vector, 1}},
+    {'V', {"VBSL", Type::Vector, 1}},
+    {'V', {"VC(EQ|GE|GT|LE|LS|LT|LZ|NT)", Type::Vector, 1}},
+    {'V', {"VCMPE?", Type::FloatingPoint, 1}},
+    {'V', {"VCVT(A|B|M|N|P|R|T)?", Type::FloatingPoint, 1}},
+    {'V', {"VDIV", Type::FloatingPoint, 1}},
+    {'V', {"VDUP", Type::Vector, 1}},
+    {'V', {"VEOR", Type::Vector, 1}},
+    {'V', {"VEXT", Type::Vector, 1}},
+    {'V', {"VFMA", Type::FloatingPoint, 1}},
+    {'V', {"VFMS", Type::FloatingPoint, 1}},
+    {'V', {"VFNMA", Type::FloatingPoint, 1}},
+    {'V', {"VFNMS", Type::FloatingPoint, 1}},
+    {'V', {"VHADD", Type::Vector, 1}},
+    {'V', {"VHSUB", Type::Vector, 1}},
     {'V', {"VLD1", Type::Load, 1}},
     {'V', {"VLD2", Type::Load, 2}},
     {'V', {"VLD3", Type::Load, 3}},
     {'V', {"VLD4", Type::Load, 4}},
     {'V', {"VLDM(DB|IA)?", Type::Load, 1}},
     {'V', {"VLDR", Type::Load, 1}},
-    {'V', {"VMAX(NM)?", Type::Other, 1}},
-    {'V', {"VMIN(NM)?", Type::Other, 1}},
-    {'V', {"VMLAL?", Type::Other, 1}},
-    {'V', {"VMLSL?", Type::Other, 1}},
-    {'V', {"VMOV(L|N)?", Type::Other, 1}},
+    {'V', {"VMAX", Type::Vector, 1}},
+    {'V', {"VMAXNM", Type::FloatingPoint, 1}},
+    {'V', {"VMIN", Type::Vector, 1}},
+    {'V', {"VMINNM", Type::FloatingPoint, 1}},
+    {'V', {"VMLA", Type::FloatingPoint, 1}},
+    {'V', {"VMLAL", Type::Vector, 1}},
+    {'V', {"VMLS", Type::FloatingPoint, 1}},
+    {'V', {"VMLSL", Type::Vector, 1}},
+    {'V', {"VMOV", Type::FloatingPoint, 1}},
+    {'V', {"VMOV(L|N)", Type::Vector, 1}},
     {'V', {"VMRS", Type::Other, 1}},
     {'V', {"VMSR", Type::Other, 1}},
-    {'V', {"VMULL?", Type::Other, 1}},
-    {'V', {"VMVN", Type::Other, 1}},
-    {'V', {"VNEG", Type::Other, 1}},
-    {'V', {"VNML(A|S)", Type::Other, 1}},
-    {'V', {"VNMUL", Type::Other, 1}},
-    {'V', {"VOR(N|R)", Type::Other, 1}},
-    {'V', {"VPADAL", Type::Other, 1}},
-    {'V', {"VPADDL?", Type::Other, 1}},
-    {'V', {"VPMAX", Type::Other, 1}},
-    {'V', {"VPMIN", Type::Other, 1}},
+    {'V', {"VMUL", Type::FloatingPoint, 1}},
+    {'V', {"VMULL", Type::Vector, 1}},
+    {'V', {"VMVN", Type::Vector, 1}},
+    {'V', {"VNEG", Type::FloatingPoint, 1}},
+    {'V', {"VNML(A|S)", Type::FloatingPoint, 1}},
+    {'V', {"VNMUL", Type::FloatingPoint, 1}},
+    {'V', {"VOR(N|R)", Type::Vector, 1}},
+    {'V', {"VPADAL", Type::Vector, 1}},
+    {'V', {"VPADDL?", Type::Vector, 1}},
+    {'V', {"VPMAX", Type::Vector, 1}},
+    {'V', {"VPMIN", Type::Vector, 1}},
     {'V', {"VPOP", Type::Other, 1}},
     {'V', {"VPUSH", Type::Other, 1}},
-    {'V', {"VQABS", Type::Other, 1}},
-    {'V', {"VQADD", Type::Other, 1}},
-    {'V', {"VQDML(AL|SL)", Type::Other, 1}},
-    {'V', {"VQDMU(LH|LL)", Type::Other, 1}},
-    {'V', {"VQMOV(N|UN)", Type::Other, 1}},
-    {'V', {"VQNEG", Type::Other, 1}},
-    {'V', {"VQRDMULH", Type::Other, 1}},
-    {'V', {"VQRSHL", Type::Other, 1}},
-    {'V', {"VQRSHRU?N", Type::Other, 1}},
-    {'V', {"VQSHLU?", Type::Other, 1}},
-    {'V', {"VQSHRU?N", Type::Other, 1}},
-    {'V', {"VQSUB", Type::Other, 1}},
-    {'V', {"VRADDHN", Type::Other, 2}},
-    {'V', {"VRECP(E|S)", Type::Other, 1}},
-    {'V', {"VREV(16|32|64)", Type::Other, 1}},
-    {'V', {"VRHADD", Type::Other, 1}},
-    {'V', {"VRINT(A|M|N|P|R|X|Z)", Type::Other, 1}},
-    {'V', {"VRSHL", Type::Other, 1}},
-    {'V', {"VRSHRN?", Type::Other, 1}},
-    {'V', {"VRSQRT(E|S)", Type::Other, 1}},
-    {'V', {"VRSRA", Type::Other, 2}},
-    {'V', {"VRSUBHN", Type::Other, 2}},
-    {'V', {"VSEL(EQ|GE|GT|VS)", Type::Other, 1}},
-    {'V', {"VSHLL?", Type::Other, 1}},
-    {'V', {"VSHRN?", Type::Other, 1}},
-    {'V', {"VSLI", Type::Other, 1}},
-    {'V', {"VSQRT", Type::Other, 1}},
-    {'V', {"VSRA", Type::Other, 1}},
-    {'V', {"VSRI", Type::Other, 1}},
+    {'V', {"VQABS", Type::Vector, 1}},
+    {'V', {"VQADD", Type::Vector, 1}},
+    {'V', {"VQDML(AL|SL)", Type::Vector, 1}},
+    {'V', {"VQDMU(LH|LL)", Type::Vector, 1}},
+    {'V', {"VQMOV(N|UN)", Type::Vector, 1}},
+    {'V', {"VQNEG", Type::Vector, 1}},
+    {'V', {"VQRDMULH", Type::Vector, 1}},
+    {'V', {"VQRSHL", Type::Vector, 1}},
+    {'V', {"VQRSHRU?N", Type::Vector, 1}},
+    {'V', {"VQSHLU?", Type::Vector, 1}},
+    {'V', {"VQSHRU?N", Type::Vector, 1}},
+    {'V', {"VQSUB", Type::Vector, 1}},
+    {'V', {"VRADDHN", Type::Vector, 2}},
+    {'V', {"VRECP(E|S)", Type::Vector, 1}},
+    {'V', {"VREV(16|32|64)", Type::Vector, 1}},
+    {'V', {"VRHADD", Type::Vector, 1}},
+    {'V', {"VRINT(A|M|N|P|R|X|Z)", Type::FloatingPoint, 1}},
+    {'V', {"VRSHL", Type::Vector, 1}},
+    {'V', {"VRSHRN?", Type::Vector, 1}},
+    {'V', {"VRSQRT(E|S)", Type::Vector, 1}},
+    {'V', {"VRSRA", Type::Vector, 2}},
+    {'V', {"VRSUBHN", Type::Vector, 2}},
+    {'V', {"VSEL(EQ|GE|GT|VS)", Type::FloatingPoint, 1}},
+    {'V', {"VSHLL?", Type::Vector, 1}},
+    {'V', {"VSHRN?", Type::Vector, 1}},
+    {'V', {"VSLI", Type::Vector, 1}},
+    {'V', {"VSQRT", Type::FloatingPoint, 1}},
+    {'V', {"VSRA", Type::Vector, 1}},
+    {'V', {"VSRI", Type::Vector, 1}},
     {'V', {"VST1", Type::Store, 1}},
     {'V', {"VST2", Type::Store, 2}},
     {'V', {"VST3", Type::Store, 4}},
     {'V', {"VST4", Type::Store, 5}},
     {'V', {"VSTM(DB|IA)?", Type::Store, 1}},
     {'V', {"VSTR", Type::Store, 1}},
-    {'V', {"VSUB", Type::Other, 1}},
-    {'V', {"VSUB(L|W)?", Type::Other, 1}},
-    {'V', {"VSUBHN", Type::Other, 1}},
-    {'V', {"VSWP", Type::Other, 1}},
-    {'V', {"VTBL", Type::Other, 1}},
-    {'V', {"VTLX", Type::Other, 1}},
-    {'V', {"VTRN", Type::Other, 2}},
-    {'V', {"VTST", Type::Other, 1}},
-    {'V', {"VUZP", Type::Other, 2}},
-    {'V', {"VZIP", Type::Other, 1}},
+    {'V', {"VSUB", Type::FloatingPoint, 1}},
+    {'V', {"VSUB(L|W)", Type::Vector, 1}},
+    {'V', {"VSUBHN", Type::Vector, 1}},
+    {'V', {"VSWP", Type::Vector, 1}},
+    {'V', {"VTBL", Type::Vector, 1}},
+    {'V', {"VTBX", Type::Vector, 1}},
+    {'V', {"VTRN", Type::Vector, 2}},
+    {'V', {"VTST", Type::Vector, 1}},
+    {'V', {"VUZP", Type::Vector, 2}},
+    {'V', {"VZIP", Type::Vector, 1}},
     {'W', {"WFE", Type::Other, 5}},
     {'W', {"WFI", Type::Other, 5}},
     {'Y', {"YIELD", Type::Other, 1}},
@@ -308,8 +317,40 @@ RuleList rule_r52 = {
     {'F', {"FCSEL", Type::FloatingPoint, 3}},
 };
 
-Type CortexR52::getStatistic(std::string &op, uint64_t &cycles) {
-  char first = op.front();
+/**
+ * Check VFP instruction is Advanced SIMD (NEON) instruction
+ *
+ * Mnemonics like VADD and VMOV are shared by VFP and NEON. NEON uses
+ * Q registers, or D registers with data type other than F64 (VFP uses S
+ * registers for single precision).
+ */
+static bool isVector(std::string &dataType, Operands &operands) {
+  static const std::regex regex_f64("f64", std::regex::icase);
+  bool f64 = std::regex_search(dataType, regex_f64);
+
+  for (auto &operand : operands) {
+    char c = tolower(operand.front());
+
+    if (operand.length() < 2 || !isdigit(operand[1])) {
+      continue;
+    }
+
+    if (c == 'q' || (c == 'd' && !dataType.empty() && !f64)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Type CortexR52::getStatistic(std::string &op, Operands &operands,
+                             uint64_t &cycles) {
+  // Match mnemonic without data type or width suffix (vadd.f32, ldr.w)
+  auto dot = op.find('.');
+  std::string mnemonic = op.substr(0, dot);
+  std::string dataType = dot == std::string::npos ? "" : op.substr(dot + 1);
+
+  char first = mnemonic.front();
   char other = first < 'a' ? first + ('a' - 'A') : first - ('a' - 'A');
 
   if (rule_r52.count(other) > 0) {
@@ -321,10 +362,17 @@ Type CortexR52::getStatistic(std::string &op, uint64_t &cycles) {
     std::smatch match;
 
     for (auto iter = range.first; iter != range.second; ++iter) {
-      if (std::regex_match(op, match, iter->second.regex)) {
+      if (std::regex_match(mnemonic, match, iter->second.regex)) {
+        auto type = iter->second.type;
+
         cycles = iter->second.cycle;
 
-        return iter->second.type;
+        if (type == Type::FloatingPoint && tolower(first) == 'v' &&
+            isVector(dataType, operands)) {
+          type = Type::Vector;
+        }
+
+        return type;
       }
     }
   }
@@ -332,4 +380,14 @@ Type CortexR52::getStatistic(std::string &op, uint64_t &cycles) {
   return Type::Ignore;
 }
 
+bool CortexR52::isCall(std::string &op) {
+  return strcasecmp(op.c_str(), "bl") == 0 ||
+         strcasecmp(op.c_str(), "blx") == 0;
+}
+
+bool CortexR52::isTailCall(std::string &op) {
+  return strcasecmp(op.c_str(), "b") == 0 ||
+         strcasecmp(op.c_str(), "b.w") == 0;
+}
+
 }  // namespace Instruction::ARM
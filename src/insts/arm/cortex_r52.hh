@@ -22,8 +22,14 @@ namespace Instruction::ARM {
  */
 class CortexR52 : public Base {
  public:
-  Type getStatistic(std::string &, uint64_t &) override;
+  Type getStatistic(std::string &, Operands &, uint64_t &) override;
+  bool isCall(std::string &) override;
+  bool isTailCall(std::string &) override;
   const char *getName() override { return "cortex-r52"; }
+
+  // One 64-bit load or store per cycle (LDRD/STRD, LDM/STM)
+  uint32_t getCopyBandwidth() override { return 4; }
+  uint32_t getSetBandwidth() override { return 8; }
 };
 
 }  // namespace Instruction::ARM
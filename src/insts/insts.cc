@@ -40,4 +40,51 @@ Base *initialize(std::string &cpuname) {
   return inst_list.front();
 }
 
+const std::vector<Base *> &getModels() {
+  return inst_list;
+}
+
+void parseOperands(const std::string &str, Operands &list) {
+  std::string current;
+  int depth = 0;
+
+  list.clear();
+
+  auto push = [&]() {
+    auto begin = current.find_first_not_of(" \t");
+    auto end = current.find_last_not_of(" \t");
+
+    if (begin != std::string::npos) {
+      list.emplace_back(current.substr(begin, end - begin + 1));
+    }
+
+    current.clear();
+  };
+
+  for (size_t i = 0; i < str.length(); i++) {
+    char c = str[i];
+
+    // Comment of AArch64 ('//') and ARM ('@')
+    if (c == '@' || (c == '/' && i + 1 < str.length() && str[i + 1] == '/')) {
+      break;
+    }
+
+    if (c == '[' || c == '{') {
+      depth++;
+    }
+    else if (c == ']' || c == '}') {
+      depth--;
+    }
+    else if (c == ',' && depth == 0) {
+      push();
+
+      continue;
+    }
+
+    current.push_back(c);
+  }
+
+  push();
+}
+
 }  // namespace Instruction
@@ -14,6 +14,7 @@
 #include <regex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace Instruction {
 
@@ -24,6 +25,7 @@ enum class Type : uint8_t {
   Arithmetic,
   FloatingPoint,
   Other,
+  Vector,  // Advanced SIMD and crypto
   Ignore,
 };
 
@@ -40,14 +42,32 @@ struct Rule {
 
 using RuleList = std::unordered_multimap<char, Rule>;
 
+// Operands of one instruction, memory operand ([...]) and register list
+// ({...}) are kept as one operand
+using Operands = std::vector<std::string>;
+
 class Base {
  public:
-  virtual Type getStatistic(std::string &, uint64_t &) = 0;
+  virtual Type getStatistic(std::string &, Operands &, uint64_t &) = 0;
+  virtual bool isCall(std::string &) = 0;
+
+  //! Unconditional direct branch, tail call when target is function
+  virtual bool isTailCall(std::string &) = 0;
   virtual const char *getName() = 0;
+
+  //! Bytes per cycle of memcpy/memmove and memset library routines
+  virtual uint32_t getCopyBandwidth() = 0;
+  virtual uint32_t getSetBandwidth() = 0;
 };
 
 Base *initialize(std::string &);
 
+//! Split operands of instruction, without trailing comment
+void parseOperands(const std::string &, Operands &);
+
+//! Every registered CPU model
+const std::vector<Base *> &getModels();
+
 };  // namespace Instruction
 
 #endif
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/interval_index.hh"
+
+#include <algorithm>
+
+namespace SimpleSSD::LLVM {
+
+IntervalIndex::IntervalIndex() : leaves(0) {}
+
+void IntervalIndex::add(uint32_t begin, uint32_t end, uint32_t id) {
+  intervals.emplace_back(Interval(begin, end, id));
+}
+
+void IntervalIndex::build() {
+  // Within same begin, rightmost one has smallest end and smallest id
+  std::sort(intervals.begin(), intervals.end(),
+            [](const Interval &a, const Interval &b) {
+              if (a.begin != b.begin) {
+                return a.begin < b.begin;
+              }
+              if (a.end != b.end) {
+                return a.end > b.end;
+              }
+
+              return a.id > b.id;
+            });
+
+  leaves = 1;
+
+  while (leaves < intervals.size()) {
+    leaves <<= 1;
+  }
+
+  tree.assign(leaves * 2, 0);
+
+  for (uint32_t i = 0; i < intervals.size(); i++) {
+    tree[leaves + i] = intervals[i].end;
+  }
+
+  for (uint32_t i = leaves - 1; i > 0; i--) {
+    tree[i] = std::max(tree[i * 2], tree[i * 2 + 1]);
+  }
+}
+
+int64_t IntervalIndex::findRightmost(uint32_t node, uint32_t left,
+                                     uint32_t right, uint32_t limit,
+                                     uint32_t end) const {
+  // Node covers [left, right), search [0, limit) for end >= query end
+  if (left >= limit || tree[node] < end) {
+    return -1;
+  }
+
+  if (right - left == 1) {
+    return left;
+  }
+
+  uint32_t mid = (left + right) / 2;
+  auto ret = findRightmost(node * 2 + 1, mid, right, limit, end);
+
+  if (ret < 0) {
+    ret = findRightmost(node * 2, left, mid, limit, end);
+  }
+
+  return ret;
+}
+
+bool IntervalIndex::find(uint32_t begin, uint32_t end, uint32_t &id) const {
+  if (intervals.size() == 0) {
+    return false;
+  }
+
+  // Number of intervals with begin <= query begin
+  uint32_t limit =
+      std::upper_bound(intervals.begin(), intervals.end(), begin,
+                       [](uint32_t value, const Interval &interval) {
+                         return value < interval.begin;
+                       }) -
+      intervals.begin();
+
+  auto idx = findRightmost(1, 0, leaves, limit, end);
+
+  if (idx < 0) {
+    return false;
+  }
+
+  id = intervals[idx].id;
+
+  return true;
+}
+
+}  // namespace SimpleSSD::LLVM
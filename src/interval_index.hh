@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_INTERVAL_INDEX_HH__
+#define __SRC_INTERVAL_INDEX_HH__
+
+#include <cinttypes>
+#include <vector>
+
+namespace SimpleSSD::LLVM {
+
+/**
+ * \brief Index of closed line ranges
+ *
+ * Finds range containing query range in O(log n). Ranges are sorted by begin
+ * and segment tree keeps maximum end of each subtree.
+ *
+ * When multiple ranges contain query, the one with largest begin is selected,
+ * then the one with smallest end, then the one added first.
+ */
+class IntervalIndex {
+ private:
+  struct Interval {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t id;
+
+    Interval(uint32_t b, uint32_t e, uint32_t i) : begin(b), end(e), id(i) {}
+  };
+
+  std::vector<Interval> intervals;
+  std::vector<uint32_t> tree;  // Max end, 1-based heap layout
+  uint32_t leaves;
+
+  int64_t findRightmost(uint32_t, uint32_t, uint32_t, uint32_t,
+                        uint32_t) const;
+
+ public:
+  IntervalIndex();
+
+  void add(uint32_t, uint32_t, uint32_t);
+  void build();
+
+  bool find(uint32_t, uint32_t, uint32_t &) const;
+};
+
+}  // namespace SimpleSSD::LLVM
+
+#endif
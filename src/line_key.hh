@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_LINE_KEY_HH__
+#define __SRC_LINE_KEY_HH__
+
+#include <cinttypes>
+
+#include "llvm/ADT/DenseMapInfo.h"
+
+namespace SimpleSSD::LLVM {
+
+/**
+ * \brief Source location of statistics
+ *
+ * Code inlined from headers has file name different with function. In
+ * bbinfo/inststat file, lines of function file are written as '  %u:' and
+ * others are written as '  %s:%u:'.
+ *
+ * File name must be interned (llvm::UniqueStringSaver), so same file always
+ * has same pointer.
+ */
+struct LineKey {
+  const char *file;
+  uint32_t line;
+
+  LineKey() : file(nullptr), line(0) {}
+  LineKey(const char *f, uint32_t l) : file(f), line(l) {}
+
+  bool operator==(const LineKey &rhs) const {
+    return line == rhs.line && file == rhs.file;
+  }
+};
+
+}  // namespace SimpleSSD::LLVM
+
+namespace llvm {
+
+template <>
+struct DenseMapInfo<SimpleSSD::LLVM::LineKey> {
+  using LineKey = SimpleSSD::LLVM::LineKey;
+
+  static inline LineKey getEmptyKey() {
+    return LineKey(DenseMapInfo<const char *>::getEmptyKey(), 0);
+  }
+
+  static inline LineKey getTombstoneKey() {
+    return LineKey(DenseMapInfo<const char *>::getTombstoneKey(), 0);
+  }
+
+  static unsigned getHashValue(const LineKey &key) {
+    return detail::combineHashValue(
+        DenseMapInfo<const char *>::getHashValue(key.file), key.line);
+  }
+
+  static bool isEqual(const LineKey &lhs, const LineKey &rhs) {
+    return lhs == rhs;
+  }
+};
+
+}  // namespace llvm
+
+#endif
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "src/runtime/profile.hh"
+
+using SimpleSSD::LLVM::Runtime::FunctionProfile;
+
+void printFunction(FunctionProfile &func, uint64_t total) {
+  std::vector<std::pair<uint64_t, uint32_t>> order;
+  uint64_t sum = 0;
+  int ret = 0;
+  auto demangled =
+      abi::__cxa_demangle(func.name.c_str(), nullptr, nullptr, &ret);
+
+  for (uint32_t i = 0; i < func.blocks.size(); i++) {
+    auto &block = func.blocks[i];
+    uint64_t cycles = block.cycles * block.count;
+
+    order.emplace_back(cycles, i);
+    sum += cycles;
+  }
+
+  // Hottest block first
+  std::stable_sort(order.begin(), order.end(),
+                   [](const std::pair<uint64_t, uint32_t> &a,
+                      const std::pair<uint64_t, uint32_t> &b) {
+                     return a.first > b.first;
+                   });
+
+  printf("func: %s\n", ret == 0 ? demangled : func.name.c_str());
+  printf(" at: %s\n", func.file.c_str());
+  printf(" cycles: %" PRIu64 " (%.2f%% of total)\n", sum,
+         total ? sum * 100. / total : 0.);
+  printf("  %-24s %8s %16s %8s %16s %8s\n", "block", "line", "count", "cost",
+         "cycles", "share");
+
+  for (auto &iter : order) {
+    auto &block = func.blocks[iter.second];
+
+    printf("  %-24s %8u %16" PRIu64 " %8" PRIu64 " %16" PRIu64 " %7.2f%%\n",
+           block.name.c_str(), block.line, block.count, block.cycles,
+           iter.first, sum ? iter.first * 100. / sum : 0.);
+  }
+
+  free(demangled);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <raw profile file>" << std::endl;
+
+    return 1;
+  }
+
+  std::vector<FunctionProfile> list;
+
+  if (!SimpleSSD::LLVM::Runtime::readProfile(argv[1], list)) {
+    std::cerr << "Failed to read profile " << argv[1] << std::endl;
+
+    return 2;
+  }
+
+  std::vector<std::pair<uint64_t, uint32_t>> order;
+  uint64_t total = 0;
+
+  for (uint32_t i = 0; i < list.size(); i++) {
+    uint64_t sum = 0;
+
+    for (auto &block : list[i].blocks) {
+      sum += block.cycles * block.count;
+    }
+
+    order.emplace_back(sum, i);
+    total += sum;
+  }
+
+  // Hottest function first
+  std::stable_sort(order.begin(), order.end(),
+                   [](const std::pair<uint64_t, uint32_t> &a,
+                      const std::pair<uint64_t, uint32_t> &b) {
+                     return a.first > b.first;
+                   });
+
+  for (auto &iter : order) {
+    printFunction(list[iter.second], total);
+  }
+
+  return 0;
+}
@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/branch.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using SimpleSSD::LLVM::Runtime::BranchModel;
+using SimpleSSD::LLVM::Runtime::BranchPredictor;
+
+//! Per branch statistics, emitted by applier
+struct Site {
+  uint64_t count;
+  uint64_t mispredicts;
+  uint64_t cycles;
+};
+
+struct Function {
+  Site *sites;
+  uint32_t branches;   //!< sites[0, branches) are conditional branches
+  uint32_t indirects;  //!< Followed by indirect branches
+};
+
+struct BTBEntry {
+  uintptr_t tag;
+  uint64_t target;
+};
+
+//! Predictor of one thread (core)
+struct Predictor {
+  uint32_t generation;
+  BranchModel model;
+
+  uint64_t history;
+  std::vector<uint8_t> counters;
+  std::vector<BTBEntry> btb;
+
+  Predictor() : generation(0), history(0) {}
+};
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+BranchModel &getModel() {
+  static BranchModel model;
+
+  return model;
+}
+
+// Incremented when model is changed
+std::atomic<uint32_t> generation(1);
+
+// Name -> functions (same function may exist in multiple modules)
+std::unordered_map<std::string, std::vector<Function>> &getIndex() {
+  static std::unordered_map<std::string, std::vector<Function>> index;
+
+  return index;
+}
+
+thread_local Predictor predictor;
+
+Predictor &getPredictor() {
+  auto current = generation.load(std::memory_order_acquire);
+
+  if (predictor.generation != current) {
+    {
+      std::lock_guard<std::mutex> guard(getLock());
+
+      predictor.model = getModel();
+    }
+
+    predictor.generation = current;
+    predictor.history = 0;
+
+    // Weakly not taken
+    predictor.counters.assign(1ull << predictor.model.tableBits, 1);
+    predictor.btb.assign(1ull << predictor.model.btbBits, BTBEntry{0, 0});
+  }
+
+  return predictor;
+}
+
+// Sites are unique per branch - use address as PC
+uint64_t getPC(const Site *site) {
+  return ((uintptr_t)site / sizeof(Site)) * 0x9e3779b97f4a7c15ull >> 16;
+}
+
+void account(Site *site, bool miss, uint32_t penalty, uint64_t *cycles) {
+  __atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED);
+
+  if (miss) {
+    __atomic_fetch_add(&site->mispredicts, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&site->cycles, penalty, __ATOMIC_RELAXED);
+
+    // Same as other counter updates of instrumented function
+    *cycles += penalty;
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+void __inststat_branch_register(const char *name, Site *sites,
+                                uint32_t branches, uint32_t indirects) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  getIndex()[name].emplace_back(Function{sites, branches, indirects});
+}
+
+void __inststat_branch(Site *site, uint8_t taken, uint64_t *cycles) {
+  auto &p = getPredictor();
+  uint64_t pc = getPC(site);
+  uint64_t mask = p.counters.size() - 1;
+  uint64_t index = pc;
+
+  if (p.model.predictor == BranchPredictor::GShare) {
+    index ^= p.history;
+  }
+
+  auto &counter = p.counters[index & mask];
+  bool predicted = counter >= 2;
+
+  if (taken) {
+    counter += counter < 3 ? 1 : 0;
+  }
+  else {
+    counter -= counter > 0 ? 1 : 0;
+  }
+
+  p.history = ((p.history << 1) | (taken ? 1 : 0)) &
+              ((1ull << p.model.historyBits) - 1);
+
+  account(site, predicted != (taken != 0), p.model.penalty, cycles);
+}
+
+void __inststat_indirect(Site *site, uint64_t target, uint64_t *cycles) {
+  auto &p = getPredictor();
+  uintptr_t pc = getPC(site);
+  auto &entry = p.btb[pc & (p.btb.size() - 1)];
+  bool hit = entry.tag == pc && entry.target == target;
+
+  entry.tag = pc;
+  entry.target = target;
+
+  account(site, !hit, p.model.indirectPenalty, cycles);
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+void setBranchModel(const BranchModel &model) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  getModel() = model;
+
+  // Sanity check - keep tables reasonable
+  getModel().tableBits = std::min(model.tableBits, 24u);
+  getModel().historyBits = std::min(model.historyBits, 63u);
+  getModel().btbBits = std::min(model.btbBits, 24u);
+
+  generation.fetch_add(1, std::memory_order_release);
+}
+
+BranchModel getBranchModel() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  return getModel();
+}
+
+bool getBranchStats(const char *name, BranchStats &stats) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &index = getIndex();
+  auto iter = index.find(name);
+
+  if (iter == index.end()) {
+    return false;
+  }
+
+  stats = BranchStats{0, 0, 0, 0, 0};
+
+  for (auto &func : iter->second) {
+    for (uint32_t i = 0; i < func.branches + func.indirects; i++) {
+      auto &site = func.sites[i];
+      uint64_t count = __atomic_load_n(&site.count, __ATOMIC_RELAXED);
+      uint64_t miss = __atomic_load_n(&site.mispredicts, __ATOMIC_RELAXED);
+
+      if (i < func.branches) {
+        stats.branches += count;
+        stats.mispredicts += miss;
+      }
+      else {
+        stats.indirects += count;
+        stats.indirectMisses += miss;
+      }
+
+      stats.cycles += __atomic_load_n(&site.cycles, __ATOMIC_RELAXED);
+    }
+  }
+
+  return true;
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_BRANCH_HH__
+#define __SRC_RUNTIME_BRANCH_HH__
+
+#include <cinttypes>
+
+namespace SimpleSSD::LLVM::Runtime {
+
+enum class BranchPredictor {
+  Bimodal,  //!< 2-bit counters indexed by branch address
+  GShare,   //!< 2-bit counters indexed by branch address XOR global history
+};
+
+struct BranchModel {
+  BranchPredictor predictor;
+
+  uint32_t tableBits;    //!< log2 of 2-bit counter entries
+  uint32_t historyBits;  //!< Global history length (GShare)
+  uint32_t btbBits;      //!< log2 of BTB entries (indirect branches)
+
+  uint32_t penalty;          //!< Cycles per conditional mispredict
+  uint32_t indirectPenalty;  //!< Cycles per BTB miss
+
+  //! Default: Cortex-A57 like (about 15 cycles refill)
+  BranchModel()
+      : predictor(BranchPredictor::GShare),
+        tableBits(12),
+        historyBits(12),
+        btbBits(9),
+        penalty(15),
+        indirectPenalty(15) {}
+};
+
+struct BranchStats {
+  uint64_t branches;     //!< Executed conditional branches
+  uint64_t mispredicts;  //!< Mispredicted conditional branches
+
+  uint64_t indirects;       //!< Executed indirect branches and calls
+  uint64_t indirectMisses;  //!< BTB misses
+
+  uint64_t cycles;  //!< Penalty cycles added to function
+};
+
+/**
+ * \brief Select branch predictor model
+ *
+ * When module is compiled with -inststat-branch, every conditional branch and
+ * indirect branch (switch, indirect call) of marked functions reports its
+ * outcome. Runtime simulates predictor of calling thread and adds penalty of
+ * mispredicted branch to cycles of function.
+ *
+ * Predictor state of all threads is reset on next branch. Cortex-R52 has
+ * shorter pipeline - use about 8 cycles of penalty.
+ */
+void setBranchModel(const BranchModel &);
+
+//! Get current branch predictor model
+BranchModel getBranchModel();
+
+/**
+ * \brief Get branch statistics of function
+ *
+ * \return False if function (mangled name) is not registered
+ */
+bool getBranchStats(const char *, BranchStats &);
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
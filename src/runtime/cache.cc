@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/cache.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "src/def.hh"
+
+namespace {
+
+using SimpleSSD::LLVM::Runtime::CacheLevel;
+using SimpleSSD::LLVM::Runtime::CacheModel;
+
+//! Set-associative cache with LRU replacement (tags only)
+struct Level {
+  uint32_t sets;
+  uint32_t ways;
+  uint32_t lineShift;
+  uint32_t latency;
+
+  std::vector<uint64_t> tags;  // Line address + 1, 0 = invalid
+  std::vector<uint64_t> ages;  // Tick of last access
+
+  void init(const CacheLevel &level) {
+    ways = std::max(level.ways, 1u);
+    lineShift = 0;
+    latency = level.latency;
+
+    while ((2u << lineShift) <= level.lineSize) {
+      lineShift++;
+    }
+
+    sets = std::max(level.size / (ways << lineShift), 1u);
+
+    tags.assign((size_t)sets * ways, 0);
+    ages.assign((size_t)sets * ways, 0);
+  }
+
+  bool access(uint64_t address, uint64_t tick) {
+    uint64_t line = address >> lineShift;
+    size_t base = (size_t)(line % sets) * ways;
+    size_t victim = base;
+
+    for (size_t i = base; i < base + ways; i++) {
+      if (tags[i] == line + 1) {
+        ages[i] = tick;
+
+        return true;
+      }
+
+      if (ages[i] < ages[victim]) {
+        victim = i;
+      }
+    }
+
+    tags[victim] = line + 1;
+    ages[victim] = tick;
+
+    return false;
+  }
+};
+
+//! Cache hierarchy of one thread (core)
+struct Simulator {
+  uint32_t generation;
+  CacheModel model;
+
+  Level l1;
+  Level l2;
+  uint64_t tick;
+
+  Simulator() : generation(0), tick(0) {}
+};
+
+struct Stats {
+  std::atomic<uint64_t> loads;
+  std::atomic<uint64_t> stores;
+  std::atomic<uint64_t> l1Misses;
+  std::atomic<uint64_t> l2Misses;
+  std::atomic<uint64_t> cycles;
+};
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+CacheModel &getModel() {
+  static CacheModel model;
+
+  return model;
+}
+
+Stats &getStats() {
+  static Stats stats;
+
+  return stats;
+}
+
+// Incremented when model is changed
+std::atomic<uint32_t> generation(1);
+
+thread_local Simulator simulator;
+
+Simulator &getSimulator() {
+  auto current = generation.load(std::memory_order_acquire);
+
+  if (simulator.generation != current) {
+    {
+      std::lock_guard<std::mutex> guard(getLock());
+
+      simulator.model = getModel();
+    }
+
+    simulator.generation = current;
+    simulator.tick = 0;
+    simulator.l1.init(simulator.model.l1);
+    simulator.l2.init(simulator.model.l2);
+  }
+
+  return simulator;
+}
+
+}  // namespace
+
+extern "C" {
+
+/**
+ * Batch of accesses, appended inline by instrumented functions
+ *
+ * Entry: bit 63 = store, bit 62:56 = size in bytes, bit 55:0 = address
+ */
+__thread uint64_t __inststat_cache_buffer[RT_CACHE_BUFFER_SIZE];
+__thread uint32_t __inststat_cache_count = 0;
+
+void __inststat_cache_flush(uint64_t *cycles) {
+  uint32_t count = __inststat_cache_count;
+
+  if (count == 0) {
+    return;
+  }
+
+  auto &sim = getSimulator();
+  uint64_t loads = 0;
+  uint64_t l1Misses = 0;
+  uint64_t l2Misses = 0;
+  uint64_t stall = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t entry = __inststat_cache_buffer[i];
+    uint64_t address = entry & ((1ull << 56) - 1);
+    uint64_t size = std::max<uint64_t>((entry >> 56) & 0x7f, 1);
+    bool store = entry >> 63;
+
+    uint64_t last = (address + size - 1) >> sim.l1.lineShift;
+    uint64_t latency = 0;
+
+    loads += store ? 0 : 1;
+
+    // Access may span multiple lines
+    for (uint64_t line = address >> sim.l1.lineShift; line <= last; line++) {
+      uint64_t lineAddress = line << sim.l1.lineShift;
+
+      sim.tick++;
+
+      if (sim.l1.access(lineAddress, sim.tick)) {
+        latency = std::max<uint64_t>(latency, sim.l1.latency);
+
+        continue;
+      }
+
+      l1Misses++;
+
+      if (sim.l2.access(lineAddress, sim.tick)) {
+        latency = std::max<uint64_t>(latency, sim.l2.latency);
+      }
+      else {
+        l2Misses++;
+        latency = std::max<uint64_t>(latency, sim.model.memoryLatency);
+      }
+    }
+
+    if (!store || sim.model.storeStall) {
+      stall += latency;
+    }
+  }
+
+  __inststat_cache_count = 0;
+
+  // Same as other counter updates of instrumented function
+  *cycles += stall;
+
+  auto &stats = getStats();
+
+  stats.loads.fetch_add(loads, std::memory_order_relaxed);
+  stats.stores.fetch_add(count - loads, std::memory_order_relaxed);
+  stats.l1Misses.fetch_add(l1Misses, std::memory_order_relaxed);
+  stats.l2Misses.fetch_add(l2Misses, std::memory_order_relaxed);
+  stats.cycles.fetch_add(stall, std::memory_order_relaxed);
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+void setCacheModel(const CacheModel &model) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  getModel() = model;
+
+  generation.fetch_add(1, std::memory_order_release);
+}
+
+CacheModel getCacheModel() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  return getModel();
+}
+
+void getCacheStats(CacheStats &stats) {
+  auto &s = getStats();
+
+  stats.loads = s.loads.load(std::memory_order_relaxed);
+  stats.stores = s.stores.load(std::memory_order_relaxed);
+  stats.l1Misses = s.l1Misses.load(std::memory_order_relaxed);
+  stats.l2Misses = s.l2Misses.load(std::memory_order_relaxed);
+  stats.cycles = s.cycles.load(std::memory_order_relaxed);
+}
+
+void resetCacheStats() {
+  auto &s = getStats();
+
+  s.loads.store(0, std::memory_order_relaxed);
+  s.stores.store(0, std::memory_order_relaxed);
+  s.l1Misses.store(0, std::memory_order_relaxed);
+  s.l2Misses.store(0, std::memory_order_relaxed);
+  s.cycles.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
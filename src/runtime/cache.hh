@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_CACHE_HH__
+#define __SRC_RUNTIME_CACHE_HH__
+
+#include <cinttypes>
+
+namespace SimpleSSD::LLVM::Runtime {
+
+struct CacheLevel {
+  uint32_t size;      //!< Bytes
+  uint32_t ways;      //!< Associativity
+  uint32_t lineSize;  //!< Bytes, power of two
+
+  uint32_t latency;  //!< Stall cycles of load hit in this level
+};
+
+struct CacheModel {
+  CacheLevel l1;
+  CacheLevel l2;
+
+  uint32_t memoryLatency;  //!< Stall cycles of load missed in all levels
+  bool storeStall;         //!< Stores also stall (no store buffer)
+
+  /**
+   * Default: Cortex-A57 like (32KB 2-way L1D, 2MB 16-way L2)
+   *
+   * Load/store cost in statistic file already includes L1 hit latency, so
+   * latency of L1 is zero.
+   */
+  CacheModel()
+      : l1{32 * 1024, 2, 64, 0},
+        l2{2 * 1024 * 1024, 16, 64, 17},
+        memoryLatency(150),
+        storeStall(false) {}
+};
+
+struct CacheStats {
+  uint64_t loads;
+  uint64_t stores;
+
+  uint64_t l1Misses;
+  uint64_t l2Misses;
+
+  uint64_t cycles;  //!< Stall cycles added to functions
+};
+
+/**
+ * \brief Select cache model
+ *
+ * When module is compiled with -inststat-cache, loads and stores of marked
+ * functions append their address to per-thread batch. Batch is simulated
+ * when it is full, before calls and at function exits, and stall cycles are
+ * added to cycles of function.
+ *
+ * Each thread simulates its own L1 and L2 (write-allocate, LRU). Cache state
+ * of all threads is reset on next simulation.
+ */
+void setCacheModel(const CacheModel &);
+
+//! Get current cache model
+CacheModel getCacheModel();
+
+//! Get cache statistics of all threads
+void getCacheStats(CacheStats &);
+
+//! Clear cache statistics
+void resetCacheStats();
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/control.hh"
+
+#include <cinttypes>
+
+extern "C" {
+
+// Read by entry of every marked function
+uint8_t __inststat_enabled = 1;
+
+// Incremented by every counter update (-inststat-count-updates)
+uint64_t __inststat_updates = 0;
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+void setInstrumentation(bool enable) {
+  __atomic_store_n(&__inststat_enabled, enable ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+bool getInstrumentation() {
+  return __atomic_load_n(&__inststat_enabled, __ATOMIC_RELAXED) != 0;
+}
+
+uint64_t getCounterUpdates() {
+  return __atomic_load_n(&__inststat_updates, __ATOMIC_RELAXED);
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_CONTROL_HH__
+#define __SRC_RUNTIME_CONTROL_HH__
+
+#include <cinttypes>
+
+namespace SimpleSSD::LLVM::Runtime {
+
+/**
+ * \brief Enable or disable instrumentation
+ *
+ * When module is compiled with -inststat-switch, marked functions check this
+ * flag at entry and run uninstrumented copy of their body when disabled.
+ * Instrumentation is enabled by default.
+ */
+void setInstrumentation(bool);
+
+//! Check instrumentation is enabled
+bool getInstrumentation();
+
+/**
+ * \brief Get number of executed counter updates
+ *
+ * Only counted when module is compiled with -inststat-count-updates, for
+ * overhead benchmark (bench/overhead.sh). Updates of all threads are added
+ * without synchronization.
+ */
+uint64_t getCounterUpdates();
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/cpu.hh"
+
+#include <algorithm>
+#include <cinttypes>
+#include <mutex>
+
+namespace {
+
+//! Cost table order of one module, emitted by applier
+struct Module {
+  std::vector<std::string> models;
+  uint32_t *index;
+};
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+std::vector<Module> &getModules() {
+  static std::vector<Module> modules;
+
+  return modules;
+}
+
+std::string &getSelected() {
+  static std::string selected;
+
+  return selected;
+}
+
+// Returns false if module falls back to primary model
+bool select(Module &module, const std::string &name) {
+  auto iter = std::find(module.models.begin(), module.models.end(), name);
+  uint32_t index = 0;
+
+  if (iter != module.models.end()) {
+    index = iter - module.models.begin();
+  }
+
+  __atomic_store_n(module.index, index, __ATOMIC_RELAXED);
+
+  return iter != module.models.end();
+}
+
+}  // namespace
+
+extern "C" {
+
+void __inststat_cpu_register(const char **names, uint32_t count,
+                             uint32_t *index) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &modules = getModules();
+
+  modules.emplace_back(Module{std::vector<std::string>(names, names + count),
+                              index});
+
+  if (getSelected().length() > 0) {
+    select(modules.back(), getSelected());
+  }
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+bool setCPUModel(const std::string &name) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  bool found = false;
+
+  getSelected() = name;
+
+  for (auto &module : getModules()) {
+    found |= select(module, name);
+  }
+
+  return found;
+}
+
+std::string getCPUModel() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  return getSelected();
+}
+
+std::vector<std::string> getCPUModels() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  std::vector<std::string> ret;
+
+  for (auto &module : getModules()) {
+    for (auto &name : module.models) {
+      if (std::find(ret.begin(), ret.end(), name) == ret.end()) {
+        ret.emplace_back(name);
+      }
+    }
+  }
+
+  return ret;
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_CPU_HH__
+#define __SRC_RUNTIME_CPU_HH__
+
+#include <string>
+#include <vector>
+
+namespace SimpleSSD::LLVM::Runtime {
+
+/**
+ * \brief Select CPU model of instruction statistics
+ *
+ * When module is compiled with -inststat-multicpu, marked functions keep cost
+ * of every CPU model found in statistic file, and add cost of selected model.
+ * Module without selected model uses its primary model (.cpu of assembly).
+ * Modules loaded later also use selected model.
+ *
+ * \return False if no registered module has this model
+ */
+bool setCPUModel(const std::string &);
+
+//! Get selected CPU model, empty if not selected
+std::string getCPUModel();
+
+//! Get CPU models of all registered modules
+std::vector<std::string> getCPUModels();
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/database.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+void copyCost(const uint64_t *cost, SimpleSSD::LLVM::Runtime::Counters &ret) {
+  ret.branch = cost[0];
+  ret.load = cost[1];
+  ret.store = cost[2];
+  ret.arithmetic = cost[3];
+  ret.floatingPoint = cost[4];
+  ret.otherInsts = cost[5];
+  ret.cycles = cost[6];
+}
+
+}  // namespace
+
+namespace SimpleSSD::LLVM::Runtime {
+
+CostDatabase::CostDatabase() : image(nullptr), size(0) {}
+
+CostDatabase::~CostDatabase() {
+  close();
+}
+
+bool CostDatabase::open(const char *path) {
+  close();
+
+  int fd = ::open(path, O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+
+    return false;
+  }
+
+  image = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  // Mapping is valid after closing descriptor
+  ::close(fd);
+
+  if (image == MAP_FAILED) {
+    image = nullptr;
+
+    return false;
+  }
+
+  size = st.st_size;
+
+  if (!view.init(image, size)) {
+    close();
+
+    return false;
+  }
+
+  return true;
+}
+
+void CostDatabase::close() {
+  if (image) {
+    munmap(image, size);
+  }
+
+  image = nullptr;
+  size = 0;
+  view = DB::View();
+}
+
+const DB::Function *CostDatabase::findFunction(const char *name,
+                                               uint64_t &hash) const {
+  if (image == nullptr) {
+    return nullptr;
+  }
+
+  auto &header = view.header();
+  auto slots = view.functionSlots();
+  uint32_t mask = header.functionSlots - 1;
+
+  hash = DB::hashName(name);
+
+  for (uint32_t i = 0; i < header.functionSlots; i++) {
+    uint32_t slot = slots[(hash + i) & mask];
+
+    if (slot == 0 || slot > header.functions) {
+      break;
+    }
+
+    auto func = view.functions() + slot - 1;
+
+    if (func->hash == hash && strcmp(view.string(func->name), name) == 0) {
+      return func;
+    }
+  }
+
+  return nullptr;
+}
+
+bool CostDatabase::getFunction(const char *name, Counters &ret) const {
+  uint64_t hash;
+  auto func = findFunction(name, hash);
+
+  if (func) {
+    copyCost(func->cost, ret);
+
+    return true;
+  }
+
+  return false;
+}
+
+bool CostDatabase::getBlock(const char *function, const char *name,
+                            Counters &ret) const {
+  uint64_t hash;
+  auto func = findFunction(function, hash);
+
+  if (func == nullptr) {
+    return false;
+  }
+
+  auto &header = view.header();
+  auto slots = view.blockSlots();
+  uint32_t mask = header.blockSlots - 1;
+  uint32_t funcidx = func - view.functions();
+
+  hash = DB::hashName(name, hash);
+
+  for (uint32_t i = 0; i < header.blockSlots; i++) {
+    uint32_t slot = slots[(hash + i) & mask];
+
+    if (slot == 0 || slot > header.blocks) {
+      break;
+    }
+
+    auto block = view.blocks() + slot - 1;
+
+    if (block->hash == hash && block->function == funcidx &&
+        strcmp(view.string(block->name), name) == 0) {
+      copyCost(block->cost, ret);
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char *CostDatabase::getModule(const char *name) const {
+  uint64_t hash;
+  auto func = findFunction(name, hash);
+
+  if (func == nullptr || func->module >= view.header().modules) {
+    return nullptr;
+  }
+
+  return view.string(view.modules()[func->module].name);
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
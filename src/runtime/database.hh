@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_DATABASE_HH__
+#define __SRC_RUNTIME_DATABASE_HH__
+
+#include <cstddef>
+
+#include "src/database_format.hh"
+#include "src/runtime/runtime.hh"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+/**
+ * \brief Read-only view of project-wide cost database
+ *
+ * Database is written by inststat-generator with --db option, and contains
+ * static costs of all marked functions and their basic blocks. File is mapped
+ * to memory and each query is single hash table lookup.
+ *
+ * Function names are mangled names. When multiple modules define function
+ * with same name, the one from first module (by name) is returned.
+ */
+class CostDatabase {
+ private:
+  void *image;
+  size_t size;
+
+  DB::View view;
+
+  const DB::Function *findFunction(const char *, uint64_t &) const;
+
+ public:
+  CostDatabase();
+  CostDatabase(const CostDatabase &) = delete;
+  ~CostDatabase();
+
+  bool open(const char *);
+  void close();
+
+  //! Sum of static costs of all blocks of function
+  bool getFunction(const char *, Counters &) const;
+
+  //! Static cost of one basic block of function
+  bool getBlock(const char *, const char *, Counters &) const;
+
+  //! Name of module which defines function
+  const char *getModule(const char *) const;
+};
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/histogram.hh"
+
+#include <cmath>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/def.hh"
+
+namespace {
+
+const uint64_t subBuckets = 1ull << RT_HISTOGRAM_SUB_BITS;
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+// Name -> bucket arrays (same function may exist in multiple modules)
+std::unordered_map<std::string, std::vector<uint64_t *>> &getIndex() {
+  static std::unordered_map<std::string, std::vector<uint64_t *>> index;
+
+  return index;
+}
+
+/**
+ * Inverse of bucket index computed by applier
+ *
+ *  shift = max(msb(v), SUB_BITS) - SUB_BITS
+ *  index = (shift << SUB_BITS) + (v >> shift)
+ */
+void getRange(uint32_t index, uint64_t &low, uint64_t &high) {
+  if (index < subBuckets * 2) {
+    low = index;
+    high = index;
+  }
+  else {
+    uint32_t shift = (index >> RT_HISTOGRAM_SUB_BITS) - 1;
+
+    low = (index - ((uint64_t)shift << RT_HISTOGRAM_SUB_BITS)) << shift;
+    high = low + ((1ull << shift) - 1);
+  }
+}
+
+// Must be called with lock held
+bool merge(const char *name, std::vector<uint64_t> &buckets) {
+  auto &index = getIndex();
+  auto iter = index.find(name);
+
+  if (iter == index.end()) {
+    return false;
+  }
+
+  buckets.assign(RT_HISTOGRAM_BUCKETS, 0);
+
+  for (auto counters : iter->second) {
+    for (uint32_t i = 0; i < RT_HISTOGRAM_BUCKETS; i++) {
+      buckets[i] += __atomic_load_n(counters + i, __ATOMIC_RELAXED);
+    }
+  }
+
+  return true;
+}
+
+uint64_t percentile(std::vector<uint64_t> &buckets, uint64_t count,
+                    double fraction) {
+  // Smallest value that fraction of invocations are less or equal to
+  uint64_t rank = (uint64_t)std::ceil(fraction * count);
+  uint64_t sum = 0;
+  uint64_t low, high = 0;
+
+  rank = rank == 0 ? 1 : rank;
+
+  for (uint32_t i = 0; i < RT_HISTOGRAM_BUCKETS; i++) {
+    sum += buckets[i];
+
+    if (sum >= rank) {
+      getRange(i, low, high);
+
+      break;
+    }
+  }
+
+  return high;
+}
+
+}  // namespace
+
+extern "C" {
+
+void __inststat_histogram_register(const char *name, uint64_t *counters) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  getIndex()[name].emplace_back(counters);
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+bool getHistogram(const char *name, HistogramSummary &summary) {
+  std::lock_guard<std::mutex> guard(getLock());
+  std::vector<uint64_t> buckets;
+
+  if (!merge(name, buckets)) {
+    return false;
+  }
+
+  double sum = 0.;
+  uint64_t low, high;
+
+  summary.count = 0;
+  summary.min = 0;
+  summary.max = 0;
+
+  for (uint32_t i = 0; i < RT_HISTOGRAM_BUCKETS; i++) {
+    if (buckets[i] == 0) {
+      continue;
+    }
+
+    getRange(i, low, high);
+
+    if (summary.count == 0) {
+      summary.min = low;
+    }
+
+    summary.max = high;
+    summary.count += buckets[i];
+    sum += buckets[i] * (low + high) / 2.;
+  }
+
+  summary.mean = summary.count ? sum / summary.count : 0.;
+  summary.p50 = percentile(buckets, summary.count, 0.5);
+  summary.p99 = percentile(buckets, summary.count, 0.99);
+  summary.p999 = percentile(buckets, summary.count, 0.999);
+
+  return true;
+}
+
+bool getPercentile(const char *name, double fraction, uint64_t &value) {
+  std::lock_guard<std::mutex> guard(getLock());
+  std::vector<uint64_t> buckets;
+  uint64_t count = 0;
+
+  if (!merge(name, buckets)) {
+    return false;
+  }
+
+  for (auto bucket : buckets) {
+    count += bucket;
+  }
+
+  if (count == 0) {
+    return false;
+  }
+
+  value = percentile(buckets, count, fraction);
+
+  return true;
+}
+
+void resetHistogram() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  for (auto &iter : getIndex()) {
+    for (auto counters : iter.second) {
+      for (uint32_t i = 0; i < RT_HISTOGRAM_BUCKETS; i++) {
+        __atomic_store_n(counters + i, 0, __ATOMIC_RELAXED);
+      }
+    }
+  }
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_HISTOGRAM_HH__
+#define __SRC_RUNTIME_HISTOGRAM_HH__
+
+#include <cinttypes>
+
+namespace SimpleSSD::LLVM::Runtime {
+
+struct HistogramSummary {
+  uint64_t count;  //!< Number of recorded invocations
+  uint64_t min;
+  uint64_t max;
+
+  double mean;
+
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t p999;
+};
+
+/**
+ * \brief Summarize cycle histogram of function
+ *
+ * When module is compiled with -inststat-histogram, cycles of each invocation
+ * of marked function are counted in log-linear buckets (32 buckets per power
+ * of two). Values are highest cycles of bucket, so relative error is below
+ * 1/32.
+ *
+ * \return False if function (mangled name) is not registered
+ */
+bool getHistogram(const char *, HistogramSummary &);
+
+/**
+ * \brief Get percentile of cycles per invocation
+ *
+ * \param[in] name     Mangled name of function
+ * \param[in] fraction Percentile in 0 ~ 1 (0.99 for p99)
+ * \param[out] value   Cycles
+ * \return False if function is not registered or has no invocation
+ */
+bool getPercentile(const char *, double, uint64_t &);
+
+//! Clear histograms of all functions
+void resetHistogram();
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
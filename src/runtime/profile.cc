@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/profile.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace {
+
+using SimpleSSD::LLVM::Runtime::ProfileBlock;
+
+struct Function {
+  const char *name;
+  const char *file;
+  uint64_t *counters;
+  const ProfileBlock *blocks;
+  uint32_t count;
+};
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+std::vector<Function> &getFunctions() {
+  static std::vector<Function> functions;
+
+  return functions;
+}
+
+void dumpProfile() {
+  const char *path = getenv(PROFILE_ENV);
+
+  SimpleSSD::LLVM::Runtime::writeProfile(path ? path : PROFILE_DEFAULT_FILE);
+}
+
+void writeString(std::ofstream &file, const char *str) {
+  uint32_t length = strlen(str);
+
+  file.write((const char *)&length, sizeof(length));
+  file.write(str, length);
+}
+
+template <class T>
+void writeValue(std::ofstream &file, T value) {
+  file.write((const char *)&value, sizeof(T));
+}
+
+bool readString(std::ifstream &file, std::string &str) {
+  uint32_t length = 0;
+
+  file.read((char *)&length, sizeof(length));
+
+  // Sanity check
+  if (!file.good() || length > (1u << 20)) {
+    return false;
+  }
+
+  str.resize(length);
+  file.read(&str[0], length);
+
+  return file.good();
+}
+
+template <class T>
+bool readValue(std::ifstream &file, T &value) {
+  file.read((char *)&value, sizeof(T));
+
+  return file.good();
+}
+
+}  // namespace
+
+extern "C" {
+
+void __inststat_profile_register(const char *name, const char *file,
+                                 uint64_t *counters, const ProfileBlock *blocks,
+                                 uint32_t count) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &functions = getFunctions();
+
+  if (functions.size() == 0) {
+    atexit(dumpProfile);
+  }
+
+  functions.emplace_back(Function{name, file, counters, blocks, count});
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+bool writeProfile(const char *path) {
+  std::lock_guard<std::mutex> guard(getLock());
+  std::ofstream file(path, std::ios::binary);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  auto &functions = getFunctions();
+
+  file.write(PROFILE_MAGIC, 8);
+  writeValue<uint32_t>(file, functions.size());
+
+  for (auto &func : functions) {
+    writeString(file, func.name);
+    writeString(file, func.file);
+    writeValue<uint32_t>(file, func.count);
+
+    for (uint32_t i = 0; i < func.count; i++) {
+      writeString(file, func.blocks[i].name);
+      writeValue<uint32_t>(file, func.blocks[i].line);
+      writeValue<uint64_t>(file, func.blocks[i].cycles);
+      writeValue<uint64_t>(file, __atomic_load_n(func.counters + i,
+                                                 __ATOMIC_RELAXED));
+    }
+  }
+
+  return file.good();
+}
+
+bool readProfile(const char *path, std::vector<FunctionProfile> &list) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[8];
+  uint32_t functions;
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file.read(magic, 8);
+
+  if (!file.good() || memcmp(magic, PROFILE_MAGIC, 8) != 0 ||
+      !readValue(file, functions)) {
+    return false;
+  }
+
+  for (uint32_t f = 0; f < functions; f++) {
+    FunctionProfile func;
+    uint32_t blocks;
+
+    if (!readString(file, func.name) || !readString(file, func.file) ||
+        !readValue(file, blocks)) {
+      return false;
+    }
+
+    for (uint32_t b = 0; b < blocks; b++) {
+      BlockProfile block;
+
+      if (!readString(file, block.name) || !readValue(file, block.line) ||
+          !readValue(file, block.cycles) || !readValue(file, block.count)) {
+        return false;
+      }
+
+      func.blocks.emplace_back(std::move(block));
+    }
+
+    list.emplace_back(std::move(func));
+  }
+
+  return true;
+}
+
+void resetProfile() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  for (auto &func : getFunctions()) {
+    for (uint32_t i = 0; i < func.count; i++) {
+      __atomic_store_n(func.counters + i, 0, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_PROFILE_HH__
+#define __SRC_RUNTIME_PROFILE_HH__
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+/**
+ * Raw profile file layout (native endian)
+ *
+ *  char[8] "ISPROF01"
+ *  uint32_t functions
+ *  Per function:
+ *   string name, string file, uint32_t blocks
+ *   Per block: string name, uint32_t line, uint64_t cycles, uint64_t count
+ *
+ * string is uint32_t length followed by characters (no null).
+ */
+#define PROFILE_MAGIC "ISPROF01"
+#define PROFILE_ENV "INSTSTAT_PROFILE_FILE"
+#define PROFILE_DEFAULT_FILE "inststat.profraw"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+//! Static metadata of basic block, emitted by applier
+struct ProfileBlock {
+  const char *name;
+  uint32_t line;
+  uint64_t cycles;  //!< Static cost of one execution
+};
+
+struct BlockProfile {
+  std::string name;
+  uint32_t line;
+  uint64_t cycles;
+  uint64_t count;
+};
+
+struct FunctionProfile {
+  std::string name;
+  std::string file;
+
+  std::vector<BlockProfile> blocks;
+};
+
+/**
+ * \brief Write block execution profile
+ *
+ * When module is compiled with -inststat-block-profile, every basic block of
+ * marked functions counts its executions. Profile is also written at exit, to
+ * file named by INSTSTAT_PROFILE_FILE environment variable (default:
+ * inststat.profraw).
+ */
+bool writeProfile(const char *);
+
+//! Read profile written by writeProfile
+bool readProfile(const char *, std::vector<FunctionProfile> &);
+
+//! Reset execution counts of all blocks
+void resetProfile();
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
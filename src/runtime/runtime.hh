@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_RUNTIME_HH__
+#define __SRC_RUNTIME_RUNTIME_HH__
+
+#include <cinttypes>
+
+namespace SimpleSSD::LLVM::Runtime {
+
+/**
+ * \brief Instruction statistics
+ *
+ * Same layout as SimpleSSD::CPU::Function.
+ */
+struct Counters {
+  uint64_t branch;
+  uint64_t load;
+  uint64_t store;
+  uint64_t arithmetic;
+  uint64_t floatingPoint;
+  uint64_t otherInsts;
+  uint64_t cycles;
+
+  Counters()
+      : branch(0),
+        load(0),
+        store(0),
+        arithmetic(0),
+        floatingPoint(0),
+        otherInsts(0),
+        cycles(0) {}
+};
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
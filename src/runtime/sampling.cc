@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/sampling.hh"
+
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Sample {
+  std::mutex lock;
+
+  uint32_t rate;
+  uint64_t count;
+  double sum;
+  double squaredSum;
+
+  Sample(uint32_t r) : rate(r), count(0), sum(0.), squaredSum(0.) {}
+};
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+// Function ID -> statistics (deque never moves elements)
+std::deque<Sample> &getSamples() {
+  static std::deque<Sample> samples;
+
+  return samples;
+}
+
+// Name -> function IDs (same function may exist in multiple modules)
+std::unordered_map<std::string, std::vector<uint32_t>> &getIndex() {
+  static std::unordered_map<std::string, std::vector<uint32_t>> index;
+
+  return index;
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t __inststat_sample_register(const char *name, uint32_t rate) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &samples = getSamples();
+  uint32_t id = samples.size();
+
+  samples.emplace_back(rate);
+  getIndex()[name].emplace_back(id);
+
+  return id;
+}
+
+void __inststat_sample_record(uint32_t id, uint64_t cycles) {
+  Sample *sample = nullptr;
+  double value = (double)cycles;
+
+  // Element does not move, but indexing reads map of deque which
+  // __inststat_sample_register may reallocate
+  {
+    std::lock_guard<std::mutex> guard(getLock());
+
+    sample = &getSamples()[id];
+  }
+
+  std::lock_guard<std::mutex> guard(sample->lock);
+
+  sample->count++;
+  sample->sum += value;
+  sample->squaredSum += value * value;
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+bool estimateSample(const char *name, SampleEstimate &estimate) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &index = getIndex();
+  auto iter = index.find(name);
+
+  if (iter == index.end()) {
+    return false;
+  }
+
+  estimate.rate = 0;
+  estimate.samples = 0;
+  estimate.cycles = 0.;
+  estimate.standardError = 0.;
+  estimate.relativeError = 0.;
+
+  double variance = 0.;
+
+  // Sum of independent estimates from each module
+  for (auto id : iter->second) {
+    auto &sample = getSamples()[id];
+
+    std::lock_guard<std::mutex> sampleGuard(sample.lock);
+
+    estimate.rate = sample.rate;
+    estimate.samples += sample.count;
+    estimate.cycles += sample.sum * sample.rate;
+
+    if (sample.count > 1) {
+      // Unbiased sample variance of cycles per invocation
+      double n = (double)sample.count;
+      double s2 = (sample.squaredSum - sample.sum * sample.sum / n) / (n - 1.);
+
+      // Var(N * sum) with finite population correction (1 - 1 / N)
+      variance += (double)sample.rate * sample.rate * n *
+                  (1. - 1. / sample.rate) * std::max(s2, 0.);
+    }
+  }
+
+  estimate.standardError = std::sqrt(variance);
+
+  if (estimate.cycles > 0.) {
+    estimate.relativeError = 1.96 * estimate.standardError / estimate.cycles;
+  }
+
+  return true;
+}
+
+bool scaleSample(const char *name, Counters &counters) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &index = getIndex();
+  auto iter = index.find(name);
+
+  if (iter == index.end()) {
+    return false;
+  }
+
+  uint64_t rate = getSamples()[iter->second.front()].rate;
+
+  counters.branch *= rate;
+  counters.load *= rate;
+  counters.store *= rate;
+  counters.arithmetic *= rate;
+  counters.floatingPoint *= rate;
+  counters.otherInsts *= rate;
+  counters.cycles *= rate;
+
+  return true;
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_SAMPLING_HH__
+#define __SRC_RUNTIME_SAMPLING_HH__
+
+#include "src/runtime/runtime.hh"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+struct SampleEstimate {
+  uint32_t rate;     //!< One of rate invocations is counted
+  uint64_t samples;  //!< Number of counted invocations
+
+  double cycles;         //!< Estimated total cycles
+  double standardError;  //!< Standard error of estimated total cycles
+  double relativeError;  //!< 95% confidence half-width / estimated cycles
+};
+
+/**
+ * \brief Estimate total cycles of sampled function
+ *
+ * When module is compiled with -inststat-sample=N, only every N-th invocation
+ * of marked function updates counters. Sampled invocations report their
+ * cycles, so total cycles of function (mangled name) can be estimated with
+ * error.
+ *
+ * \return False if function is not registered
+ */
+bool estimateSample(const char *, SampleEstimate &);
+
+/**
+ * \brief Scale counters of sampled function
+ *
+ * Multiply counters read from CPU::Function (or counter shard) of sampled
+ * function by its sampling rate.
+ *
+ * \return False if function is not registered
+ */
+bool scaleSample(const char *, Counters &);
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
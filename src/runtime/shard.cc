@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/shard.hh"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/def.hh"
+
+namespace {
+
+struct alignas(64) Slot {
+  uint64_t value[RT_SHARD_SLOT_SIZE];
+};
+
+static_assert(sizeof(Slot) == 64, "Slot must fill exactly one cache line");
+
+struct Shard {
+  Slot *slots;
+  uint32_t capacity;
+};
+
+// Extra slots allocated per thread, for functions registered later
+const uint32_t headroom = 64;
+
+std::mutex &getLock() {
+  static std::mutex lock;
+
+  return lock;
+}
+
+// Function ID -> name
+std::vector<const char *> &getNames() {
+  static std::vector<const char *> names;
+
+  return names;
+}
+
+// Name -> function IDs (same function may exist in multiple modules)
+std::unordered_map<std::string, std::vector<uint32_t>> &getIndex() {
+  static std::unordered_map<std::string, std::vector<uint32_t>> index;
+
+  return index;
+}
+
+// Shards of all threads, never freed - counters of exited threads and shards
+// replaced by larger one are still summed by reduceShard
+std::vector<Shard> &getShards() {
+  static std::vector<Shard> shards;
+
+  return shards;
+}
+
+// Shards of exited threads, reused by new threads
+std::vector<size_t> &getFree() {
+  static std::vector<size_t> list;
+
+  return list;
+}
+
+}  // namespace
+
+extern "C" {
+
+// Base pointer of counter shard of current thread
+__thread uint64_t *__inststat_shard = nullptr;
+
+// Slots in counter shard of current thread, zero before first acquire
+__thread uint32_t __inststat_shard_capacity = 0;
+
+}  // extern "C"
+
+namespace {
+
+// Set when thread-local owner is destroyed at thread exit
+__thread bool released = false;
+
+// Returns shard of current thread to free list when thread exits
+struct Owner {
+  size_t index = SIZE_MAX;
+
+  ~Owner() {
+    std::lock_guard<std::mutex> guard(getLock());
+
+    if (index != SIZE_MAX) {
+      getFree().emplace_back(index);
+    }
+
+    // Instrumented code in later thread-local destructors gets private shard
+    __inststat_shard = nullptr;
+    __inststat_shard_capacity = 0;
+    released = true;
+  }
+};
+
+}  // namespace
+
+extern "C" {
+
+uint64_t *__inststat_shard_acquire() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &shards = getShards();
+  uint32_t needed = getNames().size();
+  size_t index = SIZE_MAX;
+
+  if (!released) {
+    auto &list = getFree();
+
+    for (auto iter = list.begin(); iter != list.end(); ++iter) {
+      if (shards[*iter].capacity >= needed) {
+        index = *iter;
+        list.erase(iter);
+
+        break;
+      }
+    }
+  }
+
+  if (index == SIZE_MAX) {
+    Shard shard;
+
+    shard.capacity = needed + headroom;
+    shard.slots = (Slot *)aligned_alloc(
+        sizeof(Slot), sizeof(Slot) * (size_t)shard.capacity);
+
+    if (shard.slots == nullptr) {
+      fprintf(stderr, "inststat: Failed to allocate counter shard\n");
+      abort();
+    }
+
+    memset(shard.slots, 0, sizeof(Slot) * (size_t)shard.capacity);
+
+    index = shards.size();
+    shards.emplace_back(shard);
+  }
+
+  // When growing, previous shard is kept as is. Callers up in the stack may
+  // still update it, and its counters are summed with new one.
+  if (!released) {
+    static thread_local Owner owner;
+
+    owner.index = index;
+  }
+
+  __inststat_shard = (uint64_t *)shards[index].slots;
+  __inststat_shard_capacity = shards[index].capacity;
+
+  return __inststat_shard;
+}
+
+uint32_t __inststat_shard_register(const char *name) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &list = getNames();
+  uint32_t id = list.size();
+
+  // Threads already counting get larger shard on first call of this function
+  list.emplace_back(name);
+  getIndex()[name].emplace_back(id);
+
+  return id;
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+bool reduceShard(const char *name, Counters &counters) {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  auto &index = getIndex();
+  auto iter = index.find(name);
+
+  if (iter == index.end()) {
+    return false;
+  }
+
+  uint64_t sum[RT_SHARD_SLOT_SIZE] = {};
+
+  for (auto &shard : getShards()) {
+    for (auto id : iter->second) {
+      // Shard replaced before function is registered
+      if (id >= shard.capacity) {
+        continue;
+      }
+
+      auto &slot = shard.slots[id];
+
+      for (uint32_t i = 0; i < RT_SHARD_SLOT_SIZE; i++) {
+        // Owner thread writes without atomics - just avoid torn read
+        sum[i] += __atomic_load_n(&slot.value[i], __ATOMIC_RELAXED);
+      }
+    }
+  }
+
+  counters.branch = sum[0];
+  counters.load = sum[1];
+  counters.store = sum[2];
+  counters.arithmetic = sum[3];
+  counters.floatingPoint = sum[4];
+  counters.otherInsts = sum[5];
+  counters.cycles = sum[6];
+
+  return true;
+}
+
+void resetShard() {
+  std::lock_guard<std::mutex> guard(getLock());
+
+  // Instrumented threads should not run while resetting
+  for (auto &shard : getShards()) {
+    memset(shard.slots, 0, sizeof(Slot) * (size_t)shard.capacity);
+  }
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
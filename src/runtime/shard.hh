@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_SHARD_HH__
+#define __SRC_RUNTIME_SHARD_HH__
+
+#include "src/runtime/runtime.hh"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+/**
+ * \brief Merge per-thread counter shards
+ *
+ * When module is compiled with -inststat-shard, instrumented functions update
+ * counters of calling thread instead of CPU::Function object. This function
+ * sums counters of given function (mangled name) over all threads, including
+ * threads already terminated. Shard of terminated thread keeps its counters
+ * and is reused by next new thread, so memory grows with number of concurrent
+ * threads. Shard grows when function is registered later (dlopen).
+ *
+ * \return False if function is not registered
+ */
+bool reduceShard(const char *, Counters &);
+
+//! Reset counters of all functions in all threads
+void resetShard();
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
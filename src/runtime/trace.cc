@@ -0,0 +1,395 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/runtime/trace.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+using SimpleSSD::LLVM::Runtime::TraceEvent;
+
+// Interval of background drain
+const std::chrono::milliseconds drainInterval(10);
+
+/**
+ * Single producer (owner thread), single consumer (drain under lock)
+ *
+ * head and tail are free-running, slot is (index & (TRACE_RING_SIZE - 1)).
+ */
+struct Ring {
+  alignas(64) std::atomic<uint64_t> head;
+  alignas(64) std::atomic<uint64_t> tail;
+  alignas(64) std::atomic<uint64_t> dropped;
+  std::atomic<bool> retired;  //!< Owner thread exited
+  uint32_t thread;
+
+  TraceEvent events[TRACE_RING_SIZE];
+
+  Ring(uint32_t t) : head(0), tail(0), dropped(0), retired(false), thread(t) {}
+};
+
+static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0,
+              "TRACE_RING_SIZE must be power of two");
+
+struct State {
+  std::mutex lock;
+  std::condition_variable wakeup;
+  std::thread drainer;
+  std::ofstream file;
+
+  bool started;
+  bool stopping;
+  std::atomic<bool> closed;  //!< Checked without lock
+
+  std::vector<const char *> names;  // Function ID -> name
+  uint32_t written;                 // Function records already written
+
+  std::vector<Ring *> rings;
+  uint32_t threads;
+
+  State()
+      : started(false), stopping(false), closed(false), written(0),
+        threads(0) {}
+};
+
+State &getState() {
+  static State state;
+
+  return state;
+}
+
+// Ring of current thread - plain TLS, no initialization guard in fast path
+__thread Ring *ring = nullptr;
+__thread bool exited = false;
+
+// Retire ring when thread exits, drain thread frees it
+struct RingOwner {
+  ~RingOwner() {
+    if (ring) {
+      ring->retired.store(true, std::memory_order_release);
+    }
+
+    ring = nullptr;
+    exited = true;
+  }
+};
+
+thread_local RingOwner owner;
+
+uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+template <class T>
+void writeValue(std::ofstream &file, T value) {
+  file.write((const char *)&value, sizeof(T));
+}
+
+void writeDropped(State &state, Ring *r) {
+  uint64_t count = r->dropped.exchange(0, std::memory_order_relaxed);
+
+  if (count > 0) {
+    writeValue<uint32_t>(state.file, TRACE_DROPPED);
+    writeValue<uint32_t>(state.file, r->thread);
+    writeValue<uint64_t>(state.file, count);
+  }
+}
+
+// Must be called with lock held
+void drain(State &state) {
+  if (state.closed.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // Function records before their events
+  for (; state.written < state.names.size(); state.written++) {
+    const char *name = state.names[state.written];
+    uint32_t length = strlen(name);
+
+    writeValue<uint32_t>(state.file, TRACE_FUNCTION);
+    writeValue<uint32_t>(state.file, state.written);
+    writeValue<uint32_t>(state.file, length);
+    state.file.write(name, length);
+  }
+
+  for (auto iter = state.rings.begin(); iter != state.rings.end();) {
+    auto r = *iter;
+
+    // Check before drain - events pushed before retirement are visible
+    bool retired = r->retired.load(std::memory_order_acquire);
+    uint64_t head = r->head.load(std::memory_order_acquire);
+    uint64_t tail = r->tail.load(std::memory_order_relaxed);
+
+    while (tail != head) {
+      uint64_t begin = tail & (TRACE_RING_SIZE - 1);
+      uint64_t count = std::min<uint64_t>(head - tail, TRACE_RING_SIZE - begin);
+
+      writeValue<uint32_t>(state.file, TRACE_EVENTS);
+      writeValue<uint32_t>(state.file, (uint32_t)count);
+      state.file.write((const char *)(r->events + begin),
+                       sizeof(TraceEvent) * count);
+
+      tail += count;
+    }
+
+    r->tail.store(tail, std::memory_order_release);
+
+    if (retired) {
+      writeDropped(state, r);
+
+      delete r;
+      iter = state.rings.erase(iter);
+    }
+    else {
+      ++iter;
+    }
+  }
+
+  state.file.flush();
+}
+
+void drainLoop() {
+  auto &state = getState();
+  std::unique_lock<std::mutex> guard(state.lock);
+
+  while (!state.stopping) {
+    state.wakeup.wait_for(guard, drainInterval);
+
+    drain(state);
+  }
+}
+
+void stop() {
+  SimpleSSD::LLVM::Runtime::stopTrace();
+}
+
+// Slow path of __inststat_trace_record
+Ring *acquireRing() {
+  auto &state = getState();
+
+  if (exited || state.closed.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> guard(state.lock);
+
+  if (!state.started) {
+    const char *path = getenv(TRACE_ENV);
+
+    state.started = true;
+    state.file.open(path ? path : TRACE_DEFAULT_FILE, std::ios::binary);
+
+    if (!state.file.is_open()) {
+      fprintf(stderr, "inststat: Failed to open trace file %s\n",
+              path ? path : TRACE_DEFAULT_FILE);
+
+      state.closed = true;
+
+      return nullptr;
+    }
+
+    state.file.write(TRACE_MAGIC, 8);
+    state.drainer = std::thread(drainLoop);
+
+    atexit(stop);
+  }
+
+  if (state.stopping) {
+    return nullptr;
+  }
+
+  // Touch owner to register its destructor
+  (void)&owner;
+
+  ring = new Ring(state.threads++);
+  state.rings.emplace_back(ring);
+
+  return ring;
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t __inststat_trace_register(const char *name) {
+  auto &state = getState();
+  std::lock_guard<std::mutex> guard(state.lock);
+
+  state.names.emplace_back(name);
+
+  return state.names.size() - 1;
+}
+
+uint64_t __inststat_trace_clock() {
+  return now();
+}
+
+void __inststat_trace_record(uint32_t id, uint64_t start, uint64_t cycles) {
+  uint64_t end = now();
+  auto r = ring;
+
+  if (r == nullptr) {
+    r = acquireRing();
+
+    if (r == nullptr) {
+      return;
+    }
+  }
+
+  uint64_t head = r->head.load(std::memory_order_relaxed);
+
+  if (head - r->tail.load(std::memory_order_acquire) == TRACE_RING_SIZE) {
+    // Drain thread takes count with exchange - read-modify-write here too
+    r->dropped.fetch_add(1, std::memory_order_relaxed);
+
+    return;
+  }
+
+  auto &event = r->events[head & (TRACE_RING_SIZE - 1)];
+
+  event.id = id;
+  event.thread = r->thread;
+  event.start = start;
+  event.duration = end - start;
+  event.cycles = cycles;
+
+  r->head.store(head + 1, std::memory_order_release);
+}
+
+}  // extern "C"
+
+namespace SimpleSSD::LLVM::Runtime {
+
+void flushTrace() {
+  auto &state = getState();
+  std::lock_guard<std::mutex> guard(state.lock);
+
+  drain(state);
+}
+
+void stopTrace() {
+  auto &state = getState();
+
+  {
+    std::lock_guard<std::mutex> guard(state.lock);
+
+    if (state.stopping) {
+      return;
+    }
+
+    state.stopping = true;
+  }
+
+  state.wakeup.notify_all();
+
+  if (state.drainer.joinable()) {
+    state.drainer.join();
+  }
+
+  std::lock_guard<std::mutex> guard(state.lock);
+
+  drain(state);
+
+  if (!state.closed) {
+    // Rings of running threads are kept, only report their loss
+    for (auto r : state.rings) {
+      writeDropped(state, r);
+    }
+
+    state.file.close();
+    state.closed = true;
+  }
+}
+
+bool readTrace(const char *path, Trace &trace) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[8];
+  uint32_t type;
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file.read(magic, 8);
+
+  if (!file.good() || memcmp(magic, TRACE_MAGIC, 8) != 0) {
+    return false;
+  }
+
+  trace.functions.clear();
+  trace.events.clear();
+  trace.dropped = 0;
+
+  while (file.read((char *)&type, sizeof(type))) {
+    if (type == TRACE_FUNCTION) {
+      uint32_t id;
+      uint32_t length;
+
+      file.read((char *)&id, sizeof(id));
+      file.read((char *)&length, sizeof(length));
+
+      // Sanity check
+      if (!file.good() || length > (1u << 20) || id > (1u << 24)) {
+        return false;
+      }
+
+      if (trace.functions.size() <= id) {
+        trace.functions.resize(id + 1);
+      }
+
+      trace.functions[id].resize(length);
+      file.read(&trace.functions[id][0], length);
+    }
+    else if (type == TRACE_EVENTS) {
+      uint32_t count;
+
+      file.read((char *)&count, sizeof(count));
+
+      if (!file.good() || count > TRACE_RING_SIZE) {
+        return false;
+      }
+
+      size_t offset = trace.events.size();
+
+      trace.events.resize(offset + count);
+      file.read((char *)(trace.events.data() + offset),
+                sizeof(TraceEvent) * count);
+    }
+    else if (type == TRACE_DROPPED) {
+      uint32_t thread;
+      uint64_t count;
+
+      file.read((char *)&thread, sizeof(thread));
+      file.read((char *)&count, sizeof(count));
+
+      trace.dropped += count;
+    }
+    else {
+      return false;
+    }
+
+    if (!file.good()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace SimpleSSD::LLVM::Runtime
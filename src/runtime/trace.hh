@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_RUNTIME_TRACE_HH__
+#define __SRC_RUNTIME_TRACE_HH__
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+/**
+ * Trace file layout (native endian)
+ *
+ *  char[8] "ISTRACE1"
+ *  Sequence of records, each starts with uint32_t type:
+ *   TRACE_FUNCTION: uint32_t id, string name
+ *   TRACE_EVENTS:   uint32_t count, TraceEvent[count]
+ *   TRACE_DROPPED:  uint32_t thread, uint64_t count
+ *
+ * string is uint32_t length followed by characters (no null). Function record
+ * always precedes events of the function. File may end after any record.
+ */
+#define TRACE_MAGIC "ISTRACE1"
+#define TRACE_ENV "INSTSTAT_TRACE_FILE"
+#define TRACE_DEFAULT_FILE "inststat.trace"
+#define TRACE_RING_SIZE 8192  // Events per thread, power of two
+
+#define TRACE_FUNCTION 0
+#define TRACE_EVENTS 1
+#define TRACE_DROPPED 2
+
+namespace SimpleSSD::LLVM::Runtime {
+
+struct TraceEvent {
+  uint32_t id;        //!< Function ID
+  uint32_t thread;    //!< Thread ID (order of first traced invocation)
+  uint64_t start;     //!< Host time at entry (ns, steady clock)
+  uint64_t duration;  //!< Host time spent (ns)
+  uint64_t cycles;    //!< Modeled cycles of this invocation
+};
+
+struct Trace {
+  std::vector<std::string> functions;  //!< Function ID -> name
+  std::vector<TraceEvent> events;
+
+  uint64_t dropped;  //!< Events lost because ring buffer was full
+};
+
+/**
+ * \brief Write buffered trace events to file
+ *
+ * When module is compiled with -inststat-trace, every invocation of marked
+ * function is recorded to ring buffer of calling thread. Background thread
+ * drains rings to file named by INSTSTAT_TRACE_FILE environment variable
+ * (default: inststat.trace). This drains all rings immediately.
+ */
+void flushTrace();
+
+//! Flush and close trace file. Later events are dropped.
+void stopTrace();
+
+//! Read trace written by runtime
+bool readTrace(const char *, Trace &);
+
+}  // namespace SimpleSSD::LLVM::Runtime
+
+#endif
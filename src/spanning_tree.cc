@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/spanning_tree.hh"
+
+#include <algorithm>
+#include <numeric>
+
+namespace SimpleSSD::LLVM {
+
+SpanningTree::SpanningTree(uint32_t n) : nodes(n) {}
+
+uint32_t SpanningTree::addEdge(uint32_t src, uint32_t dst, uint64_t weight,
+                               uint8_t priority) {
+  edges.emplace_back(Edge(src, dst, weight, priority));
+
+  return edges.size() - 1;
+}
+
+bool SpanningTree::build(uint32_t root) {
+  std::vector<uint32_t> order(edges.size());
+  std::vector<uint32_t> group(nodes);
+  uint32_t treeEdges = 0;
+
+  // Sort edges by priority, and then by weight (descending)
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+    if (edges[a].priority != edges[b].priority) {
+      return edges[a].priority < edges[b].priority;
+    }
+
+    return edges[a].weight > edges[b].weight;
+  });
+
+  // Kruskal with union-find
+  std::iota(group.begin(), group.end(), 0);
+
+  auto find = [&group](uint32_t x) -> uint32_t {
+    while (group[x] != x) {
+      group[x] = group[group[x]];
+      x = group[x];
+    }
+
+    return x;
+  };
+
+  for (auto idx : order) {
+    auto &edge = edges[idx];
+    auto a = find(edge.src);
+    auto b = find(edge.dst);
+
+    if (a != b) {
+      group[a] = b;
+      edge.inTree = true;
+      treeEdges++;
+    }
+  }
+
+  // Graph is not connected
+  if (treeEdges + 1 != nodes) {
+    return false;
+  }
+
+  // Root tree
+  std::vector<std::vector<uint32_t>> adjacent(nodes);
+  std::vector<uint32_t> parentEdge(nodes, 0);
+  std::vector<uint32_t> depth(nodes, 0);
+  std::vector<bool> visited(nodes, false);
+  std::vector<uint32_t> queue;
+
+  for (uint32_t i = 0; i < edges.size(); i++) {
+    if (edges[i].inTree) {
+      adjacent[edges[i].src].emplace_back(i);
+      adjacent[edges[i].dst].emplace_back(i);
+    }
+  }
+
+  queue.reserve(nodes);
+  queue.emplace_back(root);
+  visited[root] = true;
+
+  for (uint32_t i = 0; i < queue.size(); i++) {
+    auto node = queue[i];
+
+    for (auto idx : adjacent[node]) {
+      auto &edge = edges[idx];
+      auto next = edge.src == node ? edge.dst : edge.src;
+
+      if (!visited[next]) {
+        visited[next] = true;
+        parentEdge[next] = idx;
+        depth[next] = depth[node] + 1;
+
+        queue.emplace_back(next);
+      }
+    }
+  }
+
+  // Collect chords
+  chords.clear();
+
+  for (uint32_t i = 0; i < edges.size(); i++) {
+    if (!edges[i].inTree) {
+      chords.emplace_back(i);
+    }
+  }
+
+  coefficients.assign(edges.size(), std::vector<int64_t>(chords.size(), 0));
+
+  // Chord (u -> v) closes cycle u -> v -> (tree path) -> u
+  for (uint32_t c = 0; c < chords.size(); c++) {
+    auto &chord = edges[chords[c]];
+    uint32_t v = chord.dst;
+    uint32_t u = chord.src;
+
+    coefficients[chords[c]][c] = 1;
+
+    auto parent = [this, &parentEdge](uint32_t x) -> uint32_t {
+      auto &edge = edges[parentEdge[x]];
+
+      return edge.src == x ? edge.dst : edge.src;
+    };
+
+    while (v != u) {
+      if (depth[v] >= depth[u]) {
+        // Path goes up from v side: v -> parent(v)
+        auto &edge = edges[parentEdge[v]];
+
+        coefficients[parentEdge[v]][c] += edge.src == v ? 1 : -1;
+        v = parent(v);
+      }
+      else {
+        // Path goes down to u side: parent(u) -> u
+        auto &edge = edges[parentEdge[u]];
+
+        coefficients[parentEdge[u]][c] += edge.dst == u ? 1 : -1;
+        u = parent(u);
+      }
+    }
+  }
+
+  return true;
+}
+
+}  // namespace SimpleSSD::LLVM
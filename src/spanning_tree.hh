@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __SRC_SPANNING_TREE_HH__
+#define __SRC_SPANNING_TREE_HH__
+
+#include <cinttypes>
+#include <vector>
+
+namespace SimpleSSD::LLVM {
+
+/**
+ * \brief Spanning tree for minimal counter placement
+ *
+ * Builds maximum spanning tree of control flow graph (Kruskal). Edges not in
+ * tree (chords) are the only edges need to be counted. Count of every tree
+ * edge is linear combination of chord counts, by flow conservation.
+ *
+ * Graph must be circulation - add virtual edges from exit nodes to virtual
+ * node, and virtual node to entry node.
+ */
+class SpanningTree {
+ public:
+  struct Edge {
+    uint32_t src;
+    uint32_t dst;
+
+    uint64_t weight;    //!< Larger weight -> prefer tree edge
+    uint8_t priority;   //!< Smaller priority -> processed first
+    bool inTree;
+
+    Edge(uint32_t s, uint32_t d, uint64_t w, uint8_t p)
+        : src(s), dst(d), weight(w), priority(p), inTree(false) {}
+  };
+
+ private:
+  uint32_t nodes;
+
+  std::vector<Edge> edges;
+  std::vector<uint32_t> chords;
+
+  // coefficients[edge][chord index]
+  std::vector<std::vector<int64_t>> coefficients;
+
+ public:
+  SpanningTree(uint32_t);
+
+  uint32_t addEdge(uint32_t, uint32_t, uint64_t, uint8_t);
+  bool build(uint32_t);
+
+  const std::vector<Edge> &getEdges() { return edges; }
+  const std::vector<uint32_t> &getChords() { return chords; }
+  const std::vector<int64_t> &getCoefficient(uint32_t edge) {
+    return coefficients[edge];
+  }
+};
+
+}  // namespace SimpleSSD::LLVM
+
+#endif
@@ -5,17 +5,43 @@
  * Author: Donghyun Gouk <kukdh1@camelab.org>
  */
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <regex>
 #include <string>
 #include <vector>
 
 #include "insts/insts.hh"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
+#include "src/database_writer.hh"
 #include "src/def.hh"
+#include "src/line_key.hh"
+
+using SimpleSSD::LLVM::LineKey;
+
+// Parsed names live in one arena, freed at exit. Function and file names are
+// interned - compare them by pointer
+static llvm::BumpPtrAllocator allocator;
+static llvm::UniqueStringSaver strings(allocator);
+
+static const char *intern(llvm::StringRef str) {
+  return strings.save(str).data();
+}
+
+static const char *intern(const std::ssub_match &match) {
+  return intern(llvm::StringRef(&*match.first, match.length()));
+}
+
+namespace Assembly {
 
 struct Line {
-  // Instruction count
   uint64_t branch;
   uint64_t load;
   uint64_t store;
@@ -23,9 +49,10 @@ struct Line {
   uint64_t floatingPoint;
   uint64_t otherInsts;
 
-  // Cycle consumed
   uint64_t cycles;
 
+  uint64_t vector;
+
   Line()
       : branch(0),
         load(0),
@@ -33,57 +60,158 @@ struct Line {
         arithmetic(0),
         floatingPoint(0),
         otherInsts(0),
-        cycles(0) {}
+        cycles(0),
+        vector(0) {}
+
+  void add(Instruction::Type type, uint64_t cycle) {
+    uint64_t *where = nullptr;
+
+    switch (type) {
+      case Instruction::Type::Branch:
+        where = &branch;
+        break;
+      case Instruction::Type::Load:
+        where = &load;
+        break;
+      case Instruction::Type::Store:
+        where = &store;
+        break;
+      case Instruction::Type::Arithmetic:
+        where = &arithmetic;
+        break;
+      case Instruction::Type::FloatingPoint:
+        where = &floatingPoint;
+        break;
+      case Instruction::Type::Other:
+        where = &otherInsts;
+        break;
+      case Instruction::Type::Vector:
+        where = &vector;
+        break;
+      default:
+        break;
+    }
+
+    if (where) {
+      (*where)++;
+      cycles += cycle;
+    }
+  }
+
+  Line &operator+=(const Line &rhs) {
+    branch += rhs.branch;
+    load += rhs.load;
+    store += rhs.store;
+    arithmetic += rhs.arithmetic;
+    floatingPoint += rhs.floatingPoint;
+    otherInsts += rhs.otherInsts;
+    cycles += rhs.cycles;
+    vector += rhs.vector;
+
+    return *this;
+  }
 };
 
-struct BasicBlock {
-  std::string name;
+// Line of every CPU model, primary model (.cpu of assembly) first
+struct Cost {
+  llvm::SmallVector<Line, 2> models;
+
+  Line &operator[](size_t idx) {
+    if (models.size() <= idx) {
+      models.resize(idx + 1);
+    }
+
+    return models[idx];
+  }
+
+  bool empty() const {
+    for (auto &line : models) {
+      if (line.cycles > 0) {
+        return false;
+      }
+    }
 
-  std::unordered_map<uint32_t, Line> lines;
+    return true;
+  }
+
+  Cost &operator+=(const Cost &rhs) {
+    if (models.size() < rhs.models.size()) {
+      models.resize(rhs.models.size());
+    }
+
+    for (size_t i = 0; i < rhs.models.size(); i++) {
+      models[i] += rhs.models[i];
+    }
+
+    return *this;
+  }
+};
+
+// Consecutive instructions of one source line
+struct Run {
+  LineKey key;
+  Cost cost;
+
+  // Direct call targets (bl, tail call b) at this line
+  std::vector<const char *> calls;
 };
 
 struct Function {
-  std::string name;
-  std::string file;
+  const char *name;
+  const char *file;
   uint32_t at;
 
-  std::vector<BasicBlock> blocks;
-};
+  // Instructions with line info, in assembly order
+  std::vector<Run> runs;
 
-namespace Assembly {
+  // Every instruction of function, regardless of line info
+  Cost total;
 
-struct Line {
-  uint64_t branch;
-  uint64_t load;
-  uint64_t store;
-  uint64_t arithmetic;
-  uint64_t floatingPoint;
-  uint64_t otherInsts;
+  // Direct call targets
+  std::vector<const char *> callees;
 
-  uint64_t cycles;
+  // Inclusive static cost of one invocation
+  Cost inclusive;
 
-  Line()
-      : branch(0),
-        load(0),
-        store(0),
-        arithmetic(0),
-        floatingPoint(0),
-        otherInsts(0),
-        cycles(0) {}
+  Function() : name(intern("")), file(intern("")), at(0) {}
+};
+
+}  // namespace Assembly
+
+struct BasicBlock {
+  const char *name;
+
+  // Unique lines, in order of bbinfo file
+  llvm::SmallVector<std::pair<LineKey, Assembly::Cost>, 8> lines;
 };
 
 struct Function {
-  std::string name;
-  std::string file;
+  const char *name;
+  const char *file;
   uint32_t at;
 
-  std::unordered_map<uint32_t, Line> lines;
+  std::vector<BasicBlock> blocks;
 
-  Function() : at(0) {}
+  // Inclusive cost of unmarked callees, by line of call in assembly
+  std::vector<std::pair<LineKey, Assembly::Cost>> calls;
+
+  // Primary model cycles of matched assembly function, for matching quality
+  // report of applier
+  bool matched;
+  uint64_t asmCycles;
+  uint32_t droppedLines;  // Lines without IR counterpart
+  uint64_t droppedCycles;
+
+  Function()
+      : name(intern("")),
+        file(intern("")),
+        at(0),
+        matched(false),
+        asmCycles(0),
+        droppedLines(0),
+        droppedCycles(0) {}
 };
 
-}  // namespace Assembly
-
 bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
   std::ifstream file(filename);
 
@@ -113,7 +241,7 @@ bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
   Function *current = nullptr;
   BasicBlock *bb = nullptr;
 
-  auto parseFile = [](std::string &line, std::string &file,
+  auto parseFile = [](std::string &line, const char *&file,
                       size_t from) -> uint32_t {
     auto idx = line.find_last_of(':');
 
@@ -121,14 +249,14 @@ bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
       return 0;
     }
     else {
-      file = std::move(line.substr(from, idx - from));
+      file = intern(llvm::StringRef(line).slice(from, idx));
 
       return strtoul(line.substr(idx + 1).c_str(), nullptr, 10);
     }
   };
 
   std::smatch match;
-  std::regex regex_line("  (\\d+):");
+  std::regex regex_line("  (?:(.+):)?(\\d+):");
 
   uint32_t linenumber;
 
@@ -144,9 +272,12 @@ bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
         state = FUNC_AT;
       }
       else if (std::regex_match(line, match, regex_line)) {
-        // Expect '  %u:'
-        linenumber = strtoul(match[1].str().c_str(), nullptr, 10);
-        bb->lines.emplace(linenumber, Line());
+        // Expect '  %u:' or '  %s:%u:'
+        linenumber = strtoul(match[2].str().c_str(), nullptr, 10);
+        bb->lines.emplace_back(
+            LineKey(match[1].matched ? intern(match[1]) : current->file,
+                    linenumber),
+            Assembly::Cost());
 
         // No state change
         continue;
@@ -176,7 +307,7 @@ bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
         current = &list.back();
 
         // Store function name
-        current->name = std::move(line.substr(6));
+        current->name = intern(llvm::StringRef(line).substr(6));
 
 #ifdef DEBUG_MODE
         std::cout << " Function: " << current->name << std::endl;
@@ -208,7 +339,7 @@ bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
         bb = &current->blocks.back();
 
         // Store basicblock name
-        bb->name = std::move(line.substr(8));
+        bb->name = intern(llvm::StringRef(line).substr(8));
 
         state = BLOCK;
 
@@ -222,7 +353,7 @@ bool loadBasicBlockInfo(std::vector<Function> &list, std::string filename) {
 }
 
 bool parseAssembly(std::vector<Assembly::Function> &list, std::string filename,
-                   Instruction::Base *isa) {
+                   std::vector<Instruction::Base *> &models) {
   std::ifstream file(filename);
 
   if (!file.is_open()) {
@@ -240,38 +371,99 @@ bool parseAssembly(std::vector<Assembly::Function> &list, std::string filename,
   bool inFunction = false;
   Assembly::Function *current = nullptr;
 
-  std::regex regex_loc(
-      "\\s+\\.loc\\s+\\d+\\s+\\d+\\s+\\d+.+[#@] (.+):(\\d+):\\d+",
-      std::regex::ECMAScript | std::regex::icase);
-  std::regex regex_inst("\\s+([^\\s\\.#@][\\w\\d\\.]*)\\s+.+");
-  std::regex regex_func("[#@] -- Begin function (.+)");
-  std::regex regex_end("[#@] -- End function");
+  // .file N "dir" "name" [md5 0x...] [source "..."] or .file N "name"
+  std::regex regex_file(
+      "\\s+\\.file\\s+(\\d+)\\s+\"((?:[^\"\\\\]|\\\\.)*)\""
+      "(?:\\s+\"((?:[^\"\\\\]|\\\\.)*)\")?.*");
+  std::regex regex_loc("\\s+\\.loc\\s+(\\d+)\\s+(\\d+)(?:\\s.*)?");
+  std::regex regex_inst("\\s+([^\\s\\.#@/][\\w\\d\\.]*)\\s+(.+)");
+  std::regex regex_symbol("([\\w\\.\\$]+).*");
+  std::regex regex_func("(?://|[#@]) -- Begin function (.+)");
+  std::regex regex_type("\\s+\\.type\\s+([^,\\s]+),\\s*[@%]function");
+  std::regex regex_end("(?://|[#@]) -- End function|\\.Lfunc_end\\d+:.*");
   std::regex regex_cpu("\\s+\\.cpu\\s+(.+)",
                        std::regex::ECMAScript | std::regex::icase);
 
   std::smatch match;
 
+  // File number of .loc -> interned file name (same as DIFile::getFilename)
+  llvm::DenseMap<uint32_t, const char *> files;
+
+  auto unescape = [](const std::ssub_match &str) {
+    std::string ret;
+
+    for (auto iter = str.first; iter != str.second; ++iter) {
+      if (*iter == '\\' && iter + 1 != str.second) {
+        ++iter;
+      }
+
+      ret.push_back(*iter);
+    }
+
+    return ret;
+  };
+
+  // Primary model (from .cpu) first, followed by all other models
+  auto select = [&models](std::string cpu) {
+    auto isa = Instruction::initialize(cpu);
+
+    models.emplace_back(isa);
+
+    for (auto model : Instruction::getModels()) {
+      if (model != isa) {
+        models.emplace_back(model);
+      }
+    }
+  };
+
   bool lineValid = false;
-  std::unordered_map<uint32_t, Assembly::Line>::iterator currentLine;
+
+  // Calls before first line of function, charged to first line
+  std::vector<const char *> pending;
 
   while (!file.eof()) {
     std::getline(file, line);
 
+    // File table is shared by all functions
+    if (std::regex_match(line, match, regex_file)) {
+      uint32_t number = strtoul(match[1].str().c_str(), nullptr, 10);
+
+      files[number] = intern(unescape(match[3].matched ? match[3] : match[2]));
+
+      continue;
+    }
+
     if (inFunction) {
       if (std::regex_match(line, match, regex_loc)) {
-        auto &name = match[1];
+        uint32_t number = strtoul(match[1].str().c_str(), nullptr, 10);
         uint32_t row = strtoul(match[2].str().c_str(), nullptr, 10);
+        auto iter = files.find(number);
+
+        if (iter == files.end()) {
+#ifdef DEBUG_MODE
+          std::cerr << "Unknown file number " << number << std::endl;
+#endif
+          lineValid = false;
+
+          continue;
+        }
+
+        const char *name = iter->second;
 
         if (current->at == 0) {
-          current->file = std::move(name);
+          current->file = name;
           current->at = row;
         }
         else {
-          // Ignore file name if different with function file and line 0
-          if (current->file.compare(name.str()) == 0 && row != 0) {
-            auto ret = current->lines.emplace(row, Assembly::Line());
+          // Ignore line 0
+          if (row != 0) {
+            LineKey key(name, row);
+
+            if (current->runs.empty() || !(current->runs.back().key == key)) {
+              current->runs.emplace_back(Assembly::Run{key, {}, {}});
+              current->runs.back().calls.swap(pending);
+            }
 
-            currentLine = ret.first;
             lineValid = true;
           }
           else {
@@ -280,47 +472,44 @@ bool parseAssembly(std::vector<Assembly::Function> &list, std::string filename,
         }
       }
       else if (std::regex_match(line, match, regex_inst)) {
-        if (isa == nullptr) {
+        if (models.empty()) {
           return false;
         }
 
-        if (!lineValid) {
-          continue;
-        }
-
         auto op = match[1].str();
+        Instruction::Operands operands;
 
-        // Get instruction type and cycle
-        uint64_t cycle = 0;
-        uint64_t *where = nullptr;
-        auto type = isa->getStatistic(op, cycle);
+        Instruction::parseOperands(match[2].str(), operands);
 
-        switch (type) {
-          case Instruction::Type::Branch:
-            where = &currentLine->second.branch;
-            break;
-          case Instruction::Type::Load:
-            where = &currentLine->second.load;
-            break;
-          case Instruction::Type::Store:
-            where = &currentLine->second.store;
-            break;
-          case Instruction::Type::Arithmetic:
-            where = &currentLine->second.arithmetic;
-            break;
-          case Instruction::Type::FloatingPoint:
-            where = &currentLine->second.floatingPoint;
-            break;
-          case Instruction::Type::Other:
-            where = &currentLine->second.otherInsts;
-            break;
-          default:
-            break;
+        // Get instruction type and cycle of every model
+        for (size_t i = 0; i < models.size(); i++) {
+          uint64_t cycle = 0;
+          auto type = models[i]->getStatistic(op, operands, cycle);
+
+          current->total[i].add(type, cycle);
+
+          if (lineValid) {
+            current->runs.back().cost[i].add(type, cycle);
+          }
         }
 
-        if (where) {
-          (*where)++;
-          currentLine->second.cycles += cycle;
+        if (models.front()->isCall(op) || models.front()->isTailCall(op)) {
+          auto operand = match[2].str();
+
+          // Branch to local label is not a call
+          if (std::regex_match(operand, match, regex_symbol) &&
+              match[1].str().compare(0, 2, ".L") != 0) {
+            auto name = intern(match[1]);
+
+            current->callees.emplace_back(name);
+
+            if (current->runs.empty()) {
+              pending.emplace_back(name);
+            }
+            else {
+              current->runs.back().calls.emplace_back(name);
+            }
+          }
         }
       }
       else if (std::regex_search(line, match, regex_end)) {
@@ -328,16 +517,17 @@ bool parseAssembly(std::vector<Assembly::Function> &list, std::string filename,
 
         current = nullptr;
         lineValid = false;
+        pending.clear();
       }
     }
     else {
-      if (std::regex_search(line, match, regex_func)) {
+      // Without -asm-verbose, only .type directive marks function
+      if (std::regex_search(line, match, regex_func) ||
+          std::regex_match(line, match, regex_type)) {
         auto &name = match[1];
 
-        if (isa == nullptr) {
-          std::string cpu("amd64-generic");
-
-          isa = Instruction::initialize(cpu);
+        if (models.empty()) {
+          select("amd64-generic");
         }
 
         // Append to list
@@ -345,7 +535,7 @@ bool parseAssembly(std::vector<Assembly::Function> &list, std::string filename,
         current = &list.back();
 
         // Store name
-        current->name = std::move(name);
+        current->name = intern(name);
 
 #ifdef DEBUG_MODE
         std::cout << " Function: " << current->name << std::endl;
@@ -353,10 +543,8 @@ bool parseAssembly(std::vector<Assembly::Function> &list, std::string filename,
 
         inFunction = true;
       }
-      else if (isa == nullptr && std::regex_match(line, match, regex_cpu)) {
-        auto cpu = match[1].str();
-
-        isa = Instruction::initialize(cpu);
+      else if (models.empty() && std::regex_match(line, match, regex_cpu)) {
+        select(match[1].str());
       }
     }
   }
@@ -370,29 +558,102 @@ bool generateStatistic(std::vector<Function> &bbinfo,
   std::cout << "Generating statistics" << std::endl;
 #endif
 
+  // Marked functions count themselves - callee cost only of others
+  llvm::DenseMap<const char *, Assembly::Function *> index;
+  llvm::DenseSet<const char *> marked;
+
+  for (auto &func : asmbbinfo) {
+    index.try_emplace(func.name, &func);
+  }
+
+  for (auto &func : bbinfo) {
+    marked.insert(func.name);
+  }
+
   // Matching asmbb to bbinfo
   for (auto &irfunc : bbinfo) {
     for (auto &asmfunc : asmbbinfo) {
-      // Find function
-      if (irfunc.name.compare(asmfunc.name) == 0 || irfunc.at == asmfunc.at) {
+      // Find function - by name, or by location if mangled name differs
+      if (irfunc.name == asmfunc.name ||
+          (irfunc.at != 0 && irfunc.at == asmfunc.at &&
+           irfunc.file == asmfunc.file)) {
 #ifdef DEBUG_MODE
         std::cout << "Function: " << irfunc.name << std::endl;
 #endif
+        llvm::DenseSet<LineKey> irlines;
+
+        for (auto &irbb : irfunc.blocks) {
+          for (auto &irline : irbb.lines) {
+            irlines.insert(irline.first);
+          }
+        }
+
+        // Lines not found in IR (inlined by backend, from any file) are
+        // charged to preceding IR line in assembly order. Code before first
+        // IR line goes to first IR line.
+        llvm::DenseMap<LineKey, Assembly::Cost> lines;
+        const LineKey *target = nullptr;
+
+        for (auto &run : asmfunc.runs) {
+          if (irlines.count(run.key) > 0) {
+            target = &run.key;
+
+            break;
+          }
+        }
+
+        irfunc.matched = true;
+        irfunc.asmCycles = asmfunc.total[0].cycles;
+
+        llvm::DenseSet<LineKey> dropped;
+
+        for (auto &run : asmfunc.runs) {
+          if (irlines.count(run.key) > 0) {
+            target = &run.key;
+          }
+
+          if (target) {
+            lines[*target] += run.cost;
+
+            // Calls remaining after backend inlining, at line of call
+            for (auto name : run.calls) {
+              auto callee = index.find(name);
+
+              if (callee == index.end() || marked.count(name) > 0 ||
+                  callee->second->inclusive.empty()) {
+                continue;
+              }
+
+              auto iter = std::find_if(
+                  irfunc.calls.begin(), irfunc.calls.end(),
+                  [target](auto &call) { return call.first == *target; });
+
+              if (iter == irfunc.calls.end()) {
+                irfunc.calls.emplace_back(*target, Assembly::Cost());
+                iter = std::prev(irfunc.calls.end());
+              }
+
+              iter->second += callee->second->inclusive;
+            }
+          }
+          else if (run.cost[0].cycles > 0) {
+            // No IR line at all
+            dropped.insert(run.key);
+            irfunc.droppedCycles += run.cost[0].cycles;
+          }
+        }
+
+        irfunc.droppedLines = dropped.size();
+
         // Matching basicblocks
         for (auto &irbb : irfunc.blocks) {
           // Fill each lines with line statistics
           for (auto &irline : irbb.lines) {
-            auto asmline = asmfunc.lines.find(irline.first);
+            auto asmline = lines.find(irline.first);
 
-            if (asmline != asmfunc.lines.end() && asmline->second.cycles > 0) {
+            if (asmline != lines.end() && !asmline->second.empty()) {
               // Addup stats
-              irline.second.branch += asmline->second.branch;
-              irline.second.load += asmline->second.load;
-              irline.second.store += asmline->second.store;
-              irline.second.arithmetic += asmline->second.arithmetic;
-              irline.second.floatingPoint += asmline->second.floatingPoint;
-              irline.second.otherInsts += asmline->second.otherInsts;
-              irline.second.cycles += asmline->second.cycles;
+              irline.second += asmline->second;
             }
           }
         }
@@ -405,7 +666,77 @@ bool generateStatistic(std::vector<Function> &bbinfo,
   return true;
 }
 
-bool saveStatistic(std::vector<Function> &list, std::string filename) {
+void summarizeFunctions(std::vector<Function> &bbinfo,
+                        std::vector<Assembly::Function> &asmbbinfo) {
+  // Static estimate of one invocation: every instruction of function counted
+  // once, plus inclusive cost of each direct callee defined in this module.
+  // Recursive calls and marked callees (counting themselves) are cut off.
+  llvm::DenseMap<const char *, Assembly::Function *> index;
+  llvm::DenseSet<const char *> marked;
+  llvm::DenseSet<Assembly::Function *> done;
+  llvm::DenseSet<Assembly::Function *> stack;
+
+  for (auto &func : asmbbinfo) {
+    index.try_emplace(func.name, &func);
+  }
+
+  for (auto &func : bbinfo) {
+    marked.insert(func.name);
+  }
+
+  std::function<void(Assembly::Function *)> visit =
+      [&](Assembly::Function *func) {
+        stack.insert(func);
+
+        func->inclusive = func->total;
+
+        for (auto name : func->callees) {
+          auto callee = index.find(name);
+
+          if (callee == index.end() || marked.count(name) > 0 ||
+              stack.count(callee->second) > 0) {
+            continue;
+          }
+
+          if (done.count(callee->second) == 0) {
+            visit(callee->second);
+          }
+
+          func->inclusive += callee->second->inclusive;
+        }
+
+        stack.erase(func);
+        done.insert(func);
+      };
+
+  for (auto &func : asmbbinfo) {
+    if (done.count(&func) == 0) {
+      visit(&func);
+    }
+  }
+}
+
+void writeCost(std::ostream &file, Assembly::Cost &cost, size_t count) {
+  // Primary model, then ' | ' separated values of other models. Vector count
+  // follows cycles - older files have seven values
+  for (size_t i = 0; i < count; i++) {
+    auto &line = cost[i];
+
+    if (i > 0) {
+      file << " | ";
+    }
+
+    file << line.branch << ", " << line.load << ", " << line.store << ", "
+         << line.arithmetic << ", " << line.floatingPoint << ", "
+         << line.otherInsts << ", " << line.cycles << ", " << line.vector;
+  }
+
+  file << std::endl;
+}
+
+bool saveStatistic(std::vector<Function> &list,
+                   std::vector<Instruction::Base *> &models,
+                   std::string filename) {
   std::ofstream file(filename);
 
   if (!file.is_open()) {
@@ -419,10 +750,48 @@ bool saveStatistic(std::vector<Function> &list, std::string filename) {
   std::cout << "Saving statistics to file" << filename << std::endl;
 #endif
 
+  // Order of values in each line
+  if (models.size() > 0) {
+    file << "cpu:";
+
+    for (auto model : models) {
+      file << " " << model->getName();
+    }
+
+    file << std::endl;
+
+    // Bytes per cycle of memcpy/memmove and memset, for length-based cost
+    file << "memory:";
+
+    for (size_t i = 0; i < models.size(); i++) {
+      file << (i > 0 ? " | " : " ") << models[i]->getCopyBandwidth() << ", "
+           << models[i]->getSetBandwidth();
+    }
+
+    file << std::endl;
+  }
+
   for (auto &func : list) {
     file << "func: " << func.name << std::endl;
     file << " at: " << func.file << ":" << func.at << std::endl;
 
+    if (func.matched) {
+      file << " asm: " << func.asmCycles << ", " << func.droppedLines << ", "
+           << func.droppedCycles << std::endl;
+    }
+
+    // Per-call cost of unmarked callees, for -inststat-inclusive of applier
+    for (auto &call : func.calls) {
+      if (call.first.file == func.file) {
+        file << " call: " << call.first.line << ": ";
+      }
+      else {
+        file << " call: " << call.first.file << ":" << call.first.line << ": ";
+      }
+
+      writeCost(file, call.second, models.size());
+    }
+
     for (auto &block : func.blocks) {
       if (block.lines.size() == 0) {
         continue;
@@ -431,18 +800,18 @@ bool saveStatistic(std::vector<Function> &list, std::string filename) {
       file << " block: " << block.name << std::endl;
 
       for (auto &line : block.lines) {
-        if (line.second.cycles == 0) {
+        if (line.second.empty()) {
           continue;
         }
 
-        file << "  " << line.first << ": ";
-        file << line.second.branch << ", ";
-        file << line.second.load << ", ";
-        file << line.second.store << ", ";
-        file << line.second.arithmetic << ", ";
-        file << line.second.floatingPoint << ", ";
-        file << line.second.otherInsts << ", ";
-        file << line.second.cycles << std::endl;
+        if (line.first.file == func.file) {
+          file << "  " << line.first.line << ": ";
+        }
+        else {
+          file << "  " << line.first.file << ":" << line.first.line << ": ";
+        }
+
+        writeCost(file, line.second, models.size());
       }
     }
   }
@@ -450,10 +819,172 @@ bool saveStatistic(std::vector<Function> &list, std::string filename) {
   return true;
 }
 
+bool saveDatabase(std::vector<Function> &list, std::string module,
+                  std::string filename) {
+#ifdef DEBUG_MODE
+  std::cout << "Updating cost database " << filename << std::endl;
+#endif
+
+  std::vector<SimpleSSD::LLVM::DB::FunctionCost> funclist;
+
+  for (auto &func : list) {
+    funclist.emplace_back(SimpleSSD::LLVM::DB::FunctionCost());
+
+    auto &entry = funclist.back();
+
+    entry.name = func.name;
+
+    for (auto &block : func.blocks) {
+      SimpleSSD::LLVM::DB::BlockCost cost;
+      Assembly::Line sum;
+
+      // Primary model only
+      for (auto &line : block.lines) {
+        sum += line.second[0];
+      }
+
+      if (sum.cycles == 0) {
+        continue;
+      }
+
+      cost.name = block.name;
+      cost.cost[0] = sum.branch;
+      cost.cost[1] = sum.load;
+      cost.cost[2] = sum.store;
+      cost.cost[3] = sum.arithmetic;
+      cost.cost[4] = sum.floatingPoint;
+      cost.cost[5] = sum.otherInsts + sum.vector;  // No vector counter
+      cost.cost[6] = sum.cycles;
+
+      entry.blocks.emplace_back(std::move(cost));
+    }
+  }
+
+  return SimpleSSD::LLVM::DB::updateDatabase(filename, module, funclist);
+}
+
+bool dumpBlocks(std::string filename, std::string cpu) {
+  // Write machine basic blocks with their cost, as llvm-mca code regions
+  std::ifstream file(filename);
+
+  if (!file.is_open()) {
+#ifdef DEBUG_MODE
+    std::cerr << "Failed to open file " << filename << std::endl;
+#endif
+    return false;
+  }
+
+  auto isa = Instruction::initialize(cpu);
+
+  std::regex regex_inst("\\s+([^\\s\\.#@/][\\w\\d\\.]*)(\\s+.*)?");
+  std::regex regex_label("(\\.LBB[\\w]+):.*");
+  std::regex regex_fallthrough("\\s*(?://|[#@]) %(bb\\.\\d+):.*");
+  std::regex regex_func("(?://|[#@]) -- Begin function (.+)");
+  std::regex regex_end("(?://|[#@]) -- End function");
+
+  std::smatch match;
+  std::string line;
+  std::string function;
+  std::string block;
+  std::vector<std::string> insts;
+  Assembly::Line cost;
+
+  // AArch64 asm comment is '//', ARM asm comment is '@' - both take '#' at
+  // beginning of line only on AArch64
+  const char *marker = nullptr;
+
+  auto flush = [&]() {
+    if (insts.size() > 0) {
+      marker = marker ? marker : "#";
+
+      uint64_t count = cost.branch + cost.load + cost.store + cost.arithmetic +
+                       cost.floatingPoint + cost.otherInsts + cost.vector;
+
+      std::cout << marker << " inststat " << function << ":" << block << " "
+                << count << " " << cost.cycles << "\n";
+      std::cout << marker << " LLVM-MCA-BEGIN " << function << ":" << block
+                << "\n";
+
+      for (auto &inst : insts) {
+        std::cout << inst << "\n";
+      }
+
+      std::cout << marker << " LLVM-MCA-END\n";
+    }
+
+    insts.clear();
+    cost = Assembly::Line();
+  };
+
+  while (!file.eof()) {
+    std::getline(file, line);
+
+    if (marker == nullptr) {
+      if (line.find("//") != std::string::npos) {
+        marker = "#";
+      }
+      else if (line.find("@ ") != std::string::npos) {
+        marker = "@";
+      }
+    }
+
+    if (function.length() == 0) {
+      if (std::regex_search(line, match, regex_func)) {
+        function = match[1].str();
+        block = "bb.0";
+      }
+    }
+    else if (std::regex_search(line, match, regex_end)) {
+      flush();
+      function.clear();
+    }
+    else if (std::regex_match(line, match, regex_label)) {
+      flush();
+      block = match[1].str().substr(1);
+    }
+    else if (std::regex_match(line, match, regex_fallthrough)) {
+      flush();
+      block = match[1].str();
+    }
+    else if (std::regex_match(line, match, regex_inst)) {
+      auto op = match[1].str();
+      Instruction::Operands operands;
+      uint64_t cycle = 0;
+
+      Instruction::parseOperands(match[2].str(), operands);
+
+      auto type = isa->getStatistic(op, operands, cycle);
+
+      cost.add(type, cycle);
+
+      // Drop trailing comment
+      auto comment = std::min(line.find("//"), line.find("@ "));
+
+      insts.emplace_back(line.substr(0, comment));
+    }
+  }
+
+  std::cout.flush();
+
+  return function.length() == 0;
+}
+
 int main(int argc, char *argv[]) {
   std::string bbinfo;
   std::string asmfile;
   std::string inststat;
+  std::string database;
+
+  // Machine basic block dump for cost model evaluation (bench/)
+  if (argc == 4 && strcmp(argv[1], "--blocks") == 0) {
+    return dumpBlocks(argv[2], argv[3]) ? 0 : 3;
+  }
+
+  // Optional project-wide cost database
+  if (argc == 4 && strcmp(argv[2], "--db") == 0) {
+    database = argv[3];
+    argc = 2;
+  }
 
   switch (argc) {
     case 2:
@@ -473,29 +1004,39 @@ int main(int argc, char *argv[]) {
     default:
 #ifdef DEBUG_MODE
       std::cerr << "Invalid number of arguments" << std::endl;
-      std::cerr << " Usage: " << argv[0] << " <module file name>" << std::endl;
+      std::cerr << " Usage: " << argv[0]
+                << " <module file name> [--db <database file>]" << std::endl;
+      std::cerr << "        " << argv[0] << " --blocks <assembly file> <cpu>"
+                << std::endl;
 #endif
       return 1;
   }
 
   std::vector<Function> funclist;
   std::vector<Assembly::Function> asmfunclist;
+  std::vector<Instruction::Base *> models;
 
   if (!loadBasicBlockInfo(funclist, bbinfo)) {
     return 2;
   }
 
-  if (!parseAssembly(asmfunclist, asmfile, nullptr)) {
+  if (!parseAssembly(asmfunclist, asmfile, models)) {
     return 3;
   }
 
+  summarizeFunctions(funclist, asmfunclist);
+
   if (!generateStatistic(funclist, asmfunclist)) {
     return 4;
   }
 
-  if (!saveStatistic(funclist, inststat)) {
+  if (!saveStatistic(funclist, models, inststat)) {
     return 5;
   }
 
+  if (database.length() > 0 && !saveDatabase(funclist, argv[1], database)) {
+    return 6;
+  }
+
   return 0;
 }
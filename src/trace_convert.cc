@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include <cxxabi.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+#include "src/runtime/trace.hh"
+
+using SimpleSSD::LLVM::Runtime::Trace;
+
+void printString(FILE *out, const char *str) {
+  fputc('"', out);
+
+  for (; *str; str++) {
+    if (*str == '"' || *str == '\\') {
+      fprintf(out, "\\%c", *str);
+    }
+    else if ((unsigned char)*str < 0x20) {
+      fprintf(out, "\\u%04x", *str);
+    }
+    else {
+      fputc(*str, out);
+    }
+  }
+
+  fputc('"', out);
+}
+
+/**
+ * Chrome trace event format (JSON object format), also read by Perfetto
+ *
+ * Each invocation is complete event ("ph": "X") with host time as timestamp
+ * and duration, and modeled cycles as argument.
+ */
+void printTrace(FILE *out, Trace &trace) {
+  std::vector<std::string> names;
+  uint64_t base = std::numeric_limits<uint64_t>::max();
+  bool first = true;
+
+  for (auto &name : trace.functions) {
+    int ret = 0;
+    auto demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &ret);
+
+    names.emplace_back(ret == 0 ? demangled : name);
+
+    free(demangled);
+  }
+
+  for (auto &event : trace.events) {
+    base = std::min(base, event.start);
+  }
+
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+  for (auto &event : trace.events) {
+    fprintf(out, "%s\n{\"name\":", first ? "" : ",");
+    printString(out, event.id < names.size() ? names[event.id].c_str() : "?");
+    fprintf(out,
+            ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+            "\"args\":{\"cycles\":%" PRIu64 "}}",
+            event.thread, (event.start - base) / 1000.,
+            event.duration / 1000., event.cycles);
+
+    first = false;
+  }
+
+  fprintf(out, "\n]}\n");
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <trace file> [output json file]"
+              << std::endl;
+
+    return 1;
+  }
+
+  Trace trace;
+
+  if (!SimpleSSD::LLVM::Runtime::readTrace(argv[1], trace)) {
+    std::cerr << "Failed to read trace " << argv[1] << std::endl;
+
+    return 2;
+  }
+
+  FILE *out = stdout;
+
+  if (argc == 3) {
+    out = fopen(argv[2], "w");
+
+    if (out == nullptr) {
+      std::cerr << "Failed to open output file " << argv[2] << std::endl;
+
+      return 3;
+    }
+  }
+
+  // Sort by time, threads are drained in arbitrary order
+  std::stable_sort(trace.events.begin(), trace.events.end(),
+                   [](const SimpleSSD::LLVM::Runtime::TraceEvent &a,
+                      const SimpleSSD::LLVM::Runtime::TraceEvent &b) {
+                     return a.start < b.start;
+                   });
+
+  printTrace(out, trace);
+
+  if (trace.dropped > 0) {
+    std::cerr << trace.dropped << " events were dropped (ring buffer full)"
+              << std::endl;
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  return 0;
+}
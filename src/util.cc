@@ -9,7 +9,9 @@
 
 #include <cxxabi.h>
 
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/Instructions.h"
 
 using namespace llvm;
@@ -19,7 +21,8 @@ using namespace llvm;
 
 namespace SimpleSSD::LLVM {
 
-bool Utility::isMarked(Function &func, Value **ppValue, Instruction **ppNext) {
+bool Utility::isMarked(Function &func, Value **ppValue, Instruction **ppNext,
+                       StructType **ppType) {
   // Check function
   auto &entry = func.getEntryBlock();
 
@@ -33,6 +36,10 @@ bool Utility::isMarked(Function &func, Value **ppValue, Instruction **ppNext) {
           *ppValue = call->getArgOperand(0);
         }
 
+        if (ppType) {
+          *ppType = getFunctionType(*call);
+        }
+
         // Remove this instruction
         auto next = inst.eraseFromParent();
 
@@ -48,6 +55,38 @@ bool Utility::isMarked(Function &func, Value **ppValue, Instruction **ppNext) {
   return false;
 }
 
+StructType *Utility::getFunctionType(CallBase &call) {
+  auto type = call.getArgOperand(0)->getType();
+
+#if LLVM_VERSION_MAJOR < 14
+  return dyn_cast<StructType>(type->getPointerElementType());
+#else
+#if LLVM_VERSION_MAJOR < 17
+  if (!type->isOpaquePointerTy()) {
+    return dyn_cast<StructType>(type->getNonOpaquePointerElementType());
+  }
+#endif
+
+  auto &context = call.getContext();
+
+  if (auto named = StructType::getTypeByName(context, FUNCTION_TYPE_NAME)) {
+    return named;
+  }
+
+  // Opaque pointer and type is not in module - CPU::Function is uint64_t
+  // counters, size from dereferenceable attribute of reference argument
+  uint64_t count = call.getParamDereferenceableBytes(0) / 8;
+
+  if (count == 0 && call.getCalledFunction()) {
+    count = call.getCalledFunction()->getParamDereferenceableBytes(0) / 8;
+  }
+
+  return StructType::get(context,
+                         SmallVector<Type *, 8>(std::max<uint64_t>(count, 7),
+                                                Type::getInt64Ty(context)));
+#endif
+}
+
 void Utility::printFunctionName(raw_ostream &os, Function &func) {
   int ret = 0;
   auto mangle = func.getName();
@@ -62,24 +101,24 @@ void Utility::printFunctionName(raw_ostream &os, Function &func) {
   free(funcname);
 }
 
-uint32_t Utility::getLineInfo(Instruction &inst, std::string &file) {
-  auto &debug = inst.getDebugLoc();
+uint32_t Utility::getLineInfo(Instruction &inst, const DIFile *&file) {
+  auto debug = inst.getDebugLoc().get();
 
   // Check it contains valid DILocation
-  if (debug.get() && debug.getLine() != 0) {
-    auto scope = cast<llvm::DIScope>(debug.getScope());
-    file = scope->getFilename().data();
-    return debug.getLine();
+  if (debug && debug->getLine() != 0) {
+    file = debug->getFile();
+
+    return debug->getLine();
   }
 
   return 0;
 }
 
-uint32_t Utility::getLineInfo(Function &func, std::string &file) {
+uint32_t Utility::getLineInfo(Function &func, const DIFile *&file) {
   auto subprog = func.getSubprogram();
 
   if (subprog) {
-    file = subprog->getFilename().data();
+    file = subprog->getFile();
 
     return subprog->getLine();
   }
@@ -87,14 +126,39 @@ uint32_t Utility::getLineInfo(Function &func, std::string &file) {
   return 0;
 }
 
+const DILocation *Utility::getInlinedSite(Instruction &inst) {
+  const DILocation *site = nullptr;
+  auto loc = inst.getDebugLoc().get();
+
+  // Outermost inlinedAt is location of call site in current function
+  while (loc && loc->getInlinedAt()) {
+    loc = loc->getInlinedAt();
+    site = loc;
+  }
+
+  return site;
+}
+
+uint32_t Utility::getSiteLineInfo(Instruction &inst, const DIFile *&file) {
+  auto site = getInlinedSite(inst);
+
+  if (site) {
+    file = site->getFile();
+
+    return site->getLine();
+  }
+
+  return getLineInfo(inst, file);
+}
+
 bool Utility::printLineInfo(std::ofstream &os, Instruction &inst) {
-  std::string file;
+  const DIFile *file;
   uint32_t line;
 
   line = getLineInfo(inst, file);
 
   if (line > 0) {
-    os << file << ":" << line;
+    os << file->getFilename().str() << ":" << line;
 
     return true;
   }
@@ -103,13 +167,13 @@ bool Utility::printLineInfo(std::ofstream &os, Instruction &inst) {
 }
 
 bool Utility::printLineInfo(std::ofstream &os, Function &func) {
-  std::string file;
+  const DIFile *file;
   uint32_t line;
 
   line = getLineInfo(func, file);
 
   if (line > 0) {
-    os << file << ":" << line;
+    os << file->getFilename().str() << ":" << line;
 
     return true;
   }
@@ -117,13 +181,13 @@ bool Utility::printLineInfo(std::ofstream &os, Function &func) {
   return false;
 }
 
-uint32_t Utility::getFirstLine(BasicBlock &block, std::string &file) {
+uint32_t Utility::getFirstLine(BasicBlock &block, const DIFile *&file) {
   uint32_t line = 0;
 
   auto iter = block.begin();
 
   while (iter != block.end()) {
-    line = getLineInfo(*iter, file);
+    line = getSiteLineInfo(*iter, file);
 
     if (line > 0) {
       break;
@@ -135,13 +199,13 @@ uint32_t Utility::getFirstLine(BasicBlock &block, std::string &file) {
   return line;
 }
 
-uint32_t Utility::getLastLine(BasicBlock &block, std::string &file) {
+uint32_t Utility::getLastLine(BasicBlock &block, const DIFile *&file) {
   uint32_t line = 0;
 
   auto iter = block.rbegin();
 
   while (iter != block.rend()) {
-    line = getLineInfo(*iter, file);
+    line = getSiteLineInfo(*iter, file);
 
     if (line > 0) {
       break;
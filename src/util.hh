@@ -12,6 +12,7 @@
 
 #include <fstream>
 
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
@@ -22,16 +23,20 @@ namespace SimpleSSD::LLVM {
 class Utility {
  protected:
   static bool isMarked(llvm::Function &, llvm::Value ** = nullptr,
-                       llvm::Instruction ** = nullptr);
+                       llvm::Instruction ** = nullptr,
+                       llvm::StructType ** = nullptr);
+  static llvm::StructType *getFunctionType(llvm::CallBase &);
   static void printFunctionName(llvm::raw_ostream &, llvm::Function &);
 
-  static uint32_t getLineInfo(llvm::Instruction &, std::string &);
-  static uint32_t getLineInfo(llvm::Function &, std::string &);
+  static uint32_t getLineInfo(llvm::Instruction &, const llvm::DIFile *&);
+  static uint32_t getLineInfo(llvm::Function &, const llvm::DIFile *&);
+  static const llvm::DILocation *getInlinedSite(llvm::Instruction &);
+  static uint32_t getSiteLineInfo(llvm::Instruction &, const llvm::DIFile *&);
   static bool printLineInfo(std::ofstream &, llvm::Instruction &);
   static bool printLineInfo(std::ofstream &, llvm::Function &);
 
-  static uint32_t getFirstLine(llvm::BasicBlock &, std::string &);
-  static uint32_t getLastLine(llvm::BasicBlock &, std::string &);
+  static uint32_t getFirstLine(llvm::BasicBlock &, const llvm::DIFile *&);
+  static uint32_t getLastLine(llvm::BasicBlock &, const llvm::DIFile *&);
 };
 
 }  // namespace SimpleSSD::LLVM
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#pragma once
+
+#ifndef __TEST_CHECK_HH__
+#define __TEST_CHECK_HH__
+
+#include <cstdio>
+
+// Minimal check macro of unit tests - report and keep going
+static int failures = 0;
+
+#define CHECK(cond)                                                  \
+  do {                                                               \
+    if (!(cond)) {                                                   \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+              #cond);                                                \
+                                                                     \
+      failures++;                                                    \
+    }                                                                \
+  } while (0)
+
+#endif
@@ -0,0 +1,70 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Copyright (C) 2019 CAMELab
+#
+# Author: Donghyun Gouk <kukdh1@camelab.org>
+#
+# Applies statistics to edge_profile.ll with per-block counters and with edge
+# profile, runs both and compares with hand-computed totals.
+#
+# cmake -DOPT=<opt> -DLLI=<lli> -DPASS=<pass library> -DOPT_FLAGS=<flags>
+#       -DSOURCE_DIR=<test directory> -DOUTPUT_DIR=<work directory>
+#       -P edge_profile.cmake
+
+set(EXPECTED "cycles 139000 branch 33000")
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+
+# Statistic file is found by module name, run in output directory
+configure_file(${SOURCE_DIR}/edge_profile.ll ${OUTPUT_DIR}/edge_profile.ll
+               COPYONLY)
+configure_file(${SOURCE_DIR}/edge_profile.ll.inststat.txt
+               ${OUTPUT_DIR}/edge_profile.ll.inststat.txt COPYONLY)
+
+foreach (mode block edge)
+  set(flags)
+
+  # Pass options are known after the pass is loaded
+  if (mode STREQUAL "edge")
+    list(APPEND flags -inststat-edge-profile)
+  endif ()
+
+  execute_process(
+    COMMAND ${OPT} ${OPT_FLAGS} -load ${PASS} --inststat ${flags} -S
+            -o ${mode}.inst.ll edge_profile.ll
+    WORKING_DIRECTORY ${OUTPUT_DIR}
+    RESULT_VARIABLE result
+    ERROR_VARIABLE error
+  )
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${mode}: opt failed\n${error}")
+  endif ()
+
+  # Edge profile must not fall back to per-block counters
+  file(READ ${OUTPUT_DIR}/${mode}.inst.ll ir)
+  string(FIND "${ir}" "%edge_count" found)
+
+  if (mode STREQUAL "edge" AND found EQUAL -1)
+    message(FATAL_ERROR "edge: no chord counter in ${mode}.inst.ll")
+  endif ()
+
+  execute_process(
+    COMMAND ${LLI} ${mode}.inst.ll
+    WORKING_DIRECTORY ${OUTPUT_DIR}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE error
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+  )
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${mode}: lli failed\n${error}")
+  endif ()
+
+  if (NOT output STREQUAL EXPECTED)
+    message(FATAL_ERROR "${mode}: got '${output}', expected '${EXPECTED}'")
+  endif ()
+
+  message(STATUS "${mode}: ${output}")
+endforeach ()
@@ -0,0 +1,88 @@
+; Edge profile test kernel - foo is called 1000 times over 6 positive and 4
+; non-positive values, see edge_profile.ll.inststat.txt for cost of each block
+;
+; Per call: entry 3 + loop 10 * 7 + then 6 * 3 + else 4 * 1 + latch 10 * 3
+;           + exit (1 + 13) = 139 cycles, 139000 cycles and 33000 branches
+
+%"class.SimpleSSD::CPU::Function" = type { i64, i64, i64, i64, i64, i64, i64 }
+
+@values = private constant [10 x i32] [i32 3, i32 -1, i32 4, i32 1, i32 -5, i32 9, i32 2, i32 -6, i32 5, i32 0]
+@format = private constant [25 x i8] c"cycles %llu branch %llu\0A\00"
+
+declare void @_ZN9SimpleSSD3CPU12markFunctionERNS0_8FunctionE(%"class.SimpleSSD::CPU::Function"*)
+declare i32 @printf(i8*, ...) nounwind
+
+define internal i32 @helper(i32 %x) nounwind {
+  %y = mul i32 %x, 3
+  %z = add i32 %y, 1
+  ret i32 %z
+}
+
+define void @foo(%"class.SimpleSSD::CPU::Function"* %f, i32 %n, i32* %a, i32* %out) !dbg !10 {
+entry:
+  call void @_ZN9SimpleSSD3CPU12markFunctionERNS0_8FunctionE(%"class.SimpleSSD::CPU::Function"* %f), !dbg !11
+  %c = icmp sgt i32 %n, 0, !dbg !11
+  br i1 %c, label %loop, label %exit, !dbg !11
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i1, %latch ]
+  %s = phi i32 [ 0, %entry ], [ %s2, %latch ]
+  %p = getelementptr i32, i32* %a, i32 %i, !dbg !12
+  %v = load i32, i32* %p, !dbg !12
+  %pos = icmp sgt i32 %v, 0, !dbg !12
+  br i1 %pos, label %then, label %else, !dbg !12
+then:
+  %h = call i32 @helper(i32 %v), !dbg !13
+  %sa = add i32 %s, %h, !dbg !13
+  br label %latch, !dbg !13
+else:
+  %sb = sub i32 %s, 1, !dbg !14
+  br label %latch, !dbg !14
+latch:
+  %s2 = phi i32 [ %sa, %then ], [ %sb, %else ]
+  %i1 = add i32 %i, 1, !dbg !15
+  %d = icmp slt i32 %i1, %n, !dbg !15
+  br i1 %d, label %loop, label %exit, !dbg !15
+exit:
+  %sf = phi i32 [ 0, %entry ], [ %s2, %latch ]
+  store i32 %sf, i32* %out, !dbg !16
+  ret void, !dbg !17
+}
+
+define i32 @main() {
+entry:
+  %f = alloca %"class.SimpleSSD::CPU::Function"
+  %out = alloca i32
+  store %"class.SimpleSSD::CPU::Function" zeroinitializer, %"class.SimpleSSD::CPU::Function"* %f
+  %a = getelementptr [10 x i32], [10 x i32]* @values, i32 0, i32 0
+  br label %loop
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i1, %loop ]
+  call void @foo(%"class.SimpleSSD::CPU::Function"* %f, i32 10, i32* %a, i32* %out)
+  %i1 = add i32 %i, 1
+  %d = icmp slt i32 %i1, 1000
+  br i1 %d, label %loop, label %exit
+exit:
+  %pbranch = getelementptr %"class.SimpleSSD::CPU::Function", %"class.SimpleSSD::CPU::Function"* %f, i32 0, i32 0
+  %pcycles = getelementptr %"class.SimpleSSD::CPU::Function", %"class.SimpleSSD::CPU::Function"* %f, i32 0, i32 6
+  %branch = load i64, i64* %pbranch
+  %cycles = load i64, i64* %pcycles
+  %fmt = getelementptr [25 x i8], [25 x i8]* @format, i32 0, i32 0
+  call i32 (i8*, ...) @printf(i8* %fmt, i64 %cycles, i64 %branch)
+  ret i32 0
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!2, !3}
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !DIFile(filename: "edge_profile.cc", directory: ".")
+!2 = !{i32 2, !"Debug Info Version", i32 3}
+!3 = !{i32 7, !"Dwarf Version", i32 4}
+!4 = !DISubroutineType(types: !{})
+!10 = distinct !DISubprogram(name: "foo", scope: !1, file: !1, line: 10, type: !4, spFlags: DISPFlagDefinition, unit: !0)
+!11 = !DILocation(line: 11, column: 3, scope: !10)
+!12 = !DILocation(line: 12, column: 5, scope: !10)
+!13 = !DILocation(line: 13, column: 7, scope: !10)
+!14 = !DILocation(line: 14, column: 7, scope: !10)
+!15 = !DILocation(line: 15, column: 5, scope: !10)
+!16 = !DILocation(line: 16, column: 3, scope: !10)
+!17 = !DILocation(line: 17, column: 1, scope: !10)
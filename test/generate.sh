@@ -24,7 +24,7 @@ mkdir -p $PREFIX"/"$SOURCE_DIR
 # Basic Block collection
 clang++ -std=c++17 -DEXCLUDE_CPU -g -emit-llvm -I. -I../lib/drampower/src -c $TEXT_FLAG -o $LLVM_ASSEMBLY $SOURCE_FILE
 opt --load ./lib/llvm-simplessd/build/libllvm-simplessd.so --blockcollector -O2 $TEXT_FLAG -o $LLVM_ASSEMBLY_OPT $LLVM_ASSEMBLY
-llc -O2 -filetype=asm -o $ASSEMBLY $LLVM_ASSEMBLY_OPT
+llc -O2 -asm-verbose=false -filetype=asm -o $ASSEMBLY $LLVM_ASSEMBLY_OPT
 
 # Instruction count
 ./lib/llvm-simplessd/build/inststat-generator $LLVM_ASSEMBLY
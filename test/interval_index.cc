@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/interval_index.hh"
+
+#include "test/check.hh"
+
+using namespace SimpleSSD::LLVM;
+
+int main() {
+  uint32_t id = 0;
+
+  // Empty index
+  {
+    IntervalIndex index;
+
+    index.build();
+
+    CHECK(!index.find(1, 2, id));
+  }
+
+  {
+    IntervalIndex index;
+
+    index.add(10, 20, 0);
+    index.add(12, 18, 1);
+    index.add(12, 15, 2);
+    index.add(30, 40, 3);
+    index.add(12, 15, 4);
+    index.build();
+
+    // Largest begin, then smallest end, then first added
+    CHECK(index.find(13, 14, id) && id == 2);
+    CHECK(index.find(12, 15, id) && id == 2);
+    CHECK(index.find(16, 17, id) && id == 1);
+    CHECK(index.find(11, 19, id) && id == 0);
+    CHECK(index.find(10, 20, id) && id == 0);
+    CHECK(index.find(30, 40, id) && id == 3);
+
+    // Not contained by any range
+    CHECK(!index.find(25, 26, id));
+    CHECK(!index.find(5, 50, id));
+    CHECK(!index.find(19, 31, id));
+    CHECK(!index.find(9, 11, id));
+  }
+
+  // Many ranges - compare with linear search
+  {
+    IntervalIndex index;
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+
+    for (uint32_t i = 0; i < 100; i++) {
+      uint32_t begin = (i * 37) % 200;
+      uint32_t end = begin + (i * 13) % 50;
+
+      ranges.emplace_back(begin, end);
+      index.add(begin, end, i);
+    }
+
+    index.build();
+
+    for (uint32_t begin = 0; begin < 250; begin += 3) {
+      for (uint32_t end = begin; end < begin + 30; end += 7) {
+        int64_t expected = -1;
+
+        for (uint32_t i = 0; i < ranges.size(); i++) {
+          auto &r = ranges[i];
+
+          if (r.first > begin || r.second < end) {
+            continue;
+          }
+
+          if (expected < 0 || r.first > ranges[expected].first ||
+              (r.first == ranges[expected].first &&
+               r.second < ranges[expected].second)) {
+            expected = i;
+          }
+        }
+
+        bool found = index.find(begin, end, id);
+
+        CHECK(found == (expected >= 0));
+        CHECK(!found || id == (uint32_t)expected);
+      }
+    }
+  }
+
+  return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/insts/insts.hh"
+#include "test/check.hh"
+
+using namespace Instruction;
+
+static bool equals(const std::string &str, const Operands &expected) {
+  Operands list;
+
+  parseOperands(str, list);
+
+  return list == expected;
+}
+
+int main() {
+  // Plain registers
+  CHECK(equals("x0, x1, x2", {"x0", "x1", "x2"}));
+  CHECK(equals("\tw0,w1", {"w0", "w1"}));
+
+  // Memory operand is one operand
+  CHECK(equals("x0, [x1, #8]", {"x0", "[x1, #8]"}));
+  CHECK(equals("x0, x1, [sp, #-16]!", {"x0", "x1", "[sp, #-16]!"}));
+  CHECK(equals("r0, [r1, r2, lsl #2]", {"r0", "[r1, r2, lsl #2]"}));
+
+  // Register list is one operand
+  CHECK(equals("{v0.4s, v1.4s}, [x0], #32", {"{v0.4s, v1.4s}", "[x0]", "#32"}));
+  CHECK(equals("sp!, {r4, r5, lr}", {"sp!", "{r4, r5, lr}"}));
+
+  // Trailing comments of AArch64 and ARM
+  CHECK(equals("x0, x1 // spill", {"x0", "x1"}));
+  CHECK(equals("r0, r1 @ reload", {"r0", "r1"}));
+
+  // Shifted operand and division are not comment
+  CHECK(equals("x0, x1, x2, lsl #3", {"x0", "x1", "x2", "lsl #3"}));
+  CHECK(equals("x0, :lo12:a/b", {"x0", ":lo12:a/b"}));
+
+  // No operand
+  CHECK(equals("", {}));
+  CHECK(equals("  // nothing", {}));
+
+  return failures > 0 ? 1 : 0;
+}
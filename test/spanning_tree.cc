@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+/*
+ * Copyright (C) 2019 CAMELab
+ *
+ * Author: Donghyun Gouk <kukdh1@camelab.org>
+ */
+
+#include "src/spanning_tree.hh"
+
+#include "test/check.hh"
+
+using namespace SimpleSSD::LLVM;
+
+enum : uint8_t { Fixed, Normal, Exit, Invoke };
+
+// Edge counts from chord counts, flow must be conserved at every node
+static void checkCounts(SpanningTree &tree, uint32_t nodes,
+                        const std::vector<uint64_t> &chordCounts,
+                        const std::vector<uint64_t> &expected) {
+  auto &edges = tree.getEdges();
+  std::vector<int64_t> flow(nodes, 0);
+
+  for (uint32_t e = 0; e < edges.size(); e++) {
+    auto &coeff = tree.getCoefficient(e);
+    int64_t count = 0;
+
+    for (uint32_t c = 0; c < chordCounts.size(); c++) {
+      count += coeff[c] * (int64_t)chordCounts[c];
+    }
+
+    CHECK(count == (int64_t)expected[e]);
+
+    flow[edges[e].src] -= count;
+    flow[edges[e].dst] += count;
+  }
+
+  for (auto f : flow) {
+    CHECK(f == 0);
+  }
+}
+
+int main() {
+  // Diamond: 0 -> {1, 2} -> 3, virtual node 4
+  {
+    SpanningTree tree(5);
+
+    tree.addEdge(0, 1, 10, Normal);  // 0
+    tree.addEdge(0, 2, 1, Normal);   // 1
+    tree.addEdge(1, 3, 10, Normal);  // 2
+    tree.addEdge(2, 3, 1, Normal);   // 3
+    tree.addEdge(3, 4, 0, Exit);     // 4
+    tree.addEdge(4, 0, 0, Invoke);   // 5
+
+    CHECK(tree.build(4));
+
+    // Light side of diamond and invocation edge are chords
+    auto &chords = tree.getChords();
+
+    CHECK(chords.size() == 2);
+    CHECK(chords.size() == 2 && chords[0] == 3 && chords[1] == 5);
+
+    // 7 invocations, 2 of them took 0 -> 2
+    checkCounts(tree, 5, {2, 7}, {5, 2, 5, 2, 7, 7});
+  }
+
+  // Loop: 0 -> 1 -> 2 -> 1, 2 -> 3, virtual node 4
+  {
+    SpanningTree tree(5);
+
+    tree.addEdge(0, 1, 1, Normal);   // 0
+    tree.addEdge(1, 2, 10, Normal);  // 1
+    tree.addEdge(2, 1, 9, Normal);   // 2
+    tree.addEdge(2, 3, 1, Normal);   // 3
+    tree.addEdge(3, 4, 0, Exit);     // 4
+    tree.addEdge(4, 0, 0, Invoke);   // 5
+
+    CHECK(tree.build(4));
+
+    // Back edge is counted
+    auto &chords = tree.getChords();
+
+    CHECK(chords.size() == 2);
+    CHECK(chords.size() == 2 && chords[0] == 2);
+
+    // 3 invocations, 12 iterations in total
+    checkCounts(tree, 5, {9, 3}, {3, 12, 9, 3, 3, 3});
+  }
+
+  // Fixed edge is always tree edge, even if it is lightest
+  {
+    SpanningTree tree(4);
+
+    tree.addEdge(0, 1, 10, Normal);  // 0
+    tree.addEdge(0, 2, 1, Fixed);    // 1
+    tree.addEdge(1, 2, 10, Normal);  // 2
+    tree.addEdge(2, 3, 0, Exit);     // 3
+    tree.addEdge(3, 0, 0, Invoke);   // 4
+
+    CHECK(tree.build(3));
+    CHECK(tree.getEdges()[1].inTree);
+  }
+
+  // Not connected
+  {
+    SpanningTree tree(4);
+
+    tree.addEdge(0, 1, 1, Normal);
+    tree.addEdge(1, 0, 1, Normal);
+
+    CHECK(!tree.build(0));
+  }
+
+  return failures > 0 ? 1 : 0;
+}